@@ -148,6 +148,95 @@ void motorControlSubmenu(MecanumDrive &drive) {
   }
 }
 
+void printLatencyReport(const LatencyProbe &probe) {
+  Serial.println(F("==================================="));
+  Serial.println(F("   Latency from input (us)         "));
+  Serial.println(F("==================================="));
+  Serial.println(F("stage\tcount\tmin\tmean\tp50\tp90\tp99\tmax"));
+  for (int stage = LatencyProbe::STAGE_UPDATE; stage < LatencyProbe::STAGE_COUNT; stage++) {
+    const LatencyStats &stats = probe.getStats(static_cast<LatencyProbe::Stage>(stage));
+    Serial.print(LatencyProbe::stageName(static_cast<LatencyProbe::Stage>(stage)));
+    Serial.print(F("\t"));
+    Serial.print(stats.getCount());
+    Serial.print(F("\t"));
+    Serial.print(stats.getMin());
+    Serial.print(F("\t"));
+    Serial.print(stats.getMean());
+    Serial.print(F("\t"));
+    Serial.print(stats.getPercentile(50));
+    Serial.print(F("\t"));
+    Serial.print(stats.getPercentile(90));
+    Serial.print(F("\t"));
+    Serial.print(stats.getPercentile(99));
+    Serial.print(F("\t"));
+    Serial.println(stats.getMax());
+  }
+  Serial.println(F("==================================="));
+}
+
+// Scripted step inputs as raw stick values {x, y, turn}, following the
+// cardinal direction commands with a return to neutral after each step
+const int16_t latencySteps[][3] = {
+  {0, 32767, 0}, {0, 0, 0},       // North
+  {32767, 0, 0}, {0, 0, 0},       // East
+  {-32767, 0, 0}, {0, 0, 0},      // West
+  {0, -32767, 0}, {0, 0, 0},      // South
+  {32767, 32767, 0}, {0, 0, 0},   // Northeast
+  {-32767, 32767, 0}, {0, 0, 0},  // Northwest
+  {32767, -32767, 0}, {0, 0, 0},  // Southeast
+  {-32767, -32767, 0}, {0, 0, 0}, // Southwest
+  {0, 0, 32767}, {0, 0, 0},       // Rotate right
+  {0, 0, -32767}, {0, 0, 0}       // Rotate left
+};
+const int latencyStepCount = sizeof(latencySteps) / sizeof(latencySteps[0]);
+const int latencyRepetitions = 20;
+
+void runLatencyCharacterization(MecanumDrive &drive, XboxController &xbox, LatencyProbe &probe) {
+  Serial.println(F("Running scripted latency characterization."));
+  Serial.println(F("Motors stay disabled, DAC outputs are driven."));
+  drive.disableMotors();
+
+  probe.reset();
+  probe.arm();
+  for (int repetition = 0; repetition < latencyRepetitions; repetition++) {
+    for (int step = 0; step < latencyStepCount; step++) {
+      probe.mark(LatencyProbe::STAGE_INPUT);
+      xbox.setScriptedInput(latencySteps[step][0], latencySteps[step][1], latencySteps[step][2]);
+      xbox.update();
+      drive.move(xbox.getX(), xbox.getY(), xbox.getTurn());
+    }
+  }
+  probe.disarm();
+  xbox.clearScriptedInput();
+  drive.resetDACOutputs();
+
+  printLatencyReport(probe);
+}
+
+// Print per-wheel velocity tracking, in encoder counts per control tick
+void printVelocityTelemetry(MecanumDrive &drive) {
+  WheelVelocityController &controller = drive.getVelocityController();
+  const char *wheelNames[] = {"FL", "FR", "RL", "RR"};
+
+  Serial.print(F("Closed loop: "));
+  Serial.println(drive.isClosedLoopEnabled() ? F("on") : F("off"));
+  Serial.println(F("wheel\ttarget\tmeasured\terror\tmax|err|\tmean|err|"));
+  for (uint8_t wheel = 0; wheel < WheelVelocityController::WHEELS; wheel++) {
+    Serial.print(wheelNames[wheel]);
+    Serial.print(F("\t"));
+    Serial.print(controller.getTarget(wheel) / 16.0, 2);
+    Serial.print(F("\t"));
+    Serial.print(controller.getMeasured(wheel) / 16.0, 2);
+    Serial.print(F("\t\t"));
+    Serial.print(controller.getError(wheel) / 16.0, 2);
+    Serial.print(F("\t"));
+    Serial.print(controller.getMaxAbsError(wheel) / 16.0, 2);
+    Serial.print(F("\t\t"));
+    Serial.println(controller.getMeanAbsError(wheel) / 16.0, 2);
+  }
+  controller.resetTelemetry();
+}
+
 void printDebugMenu() {
   Serial.println(F("==================================="));
   Serial.println(F("           Debug Mode Menu         "));
@@ -156,10 +245,20 @@ void printDebugMenu() {
   Serial.println(F("  [q] Exit Debug Mode"));
   Serial.println(F("  [s] System Status"));
   Serial.println(F("  [m] Motor Control Submenu"));
+  Serial.println(F("  [l] Latency Characterization"));
+  Serial.println(F("  [v] Wheel Velocity Telemetry"));
   Serial.println(F("==================================="));
 }
 
-void enterDebugMode(MecanumDrive &drive, XboxController &xbox) {
+void enterDebugMode(MecanumDrive &drive, XboxController &xbox, LatencyProbe &probe) {
+  // The velocity loop only runs from loop(), which is blocked here, so the
+  // debug commands drive the DAC open loop
+  bool closedLoop = drive.isClosedLoopEnabled();
+  if (closedLoop) {
+    drive.setClosedLoopEnabled(false);
+    Serial.println(F("Closed loop paused while in debug mode."));
+  }
+
   // Print the debug menu initially
   printDebugMenu();
 
@@ -168,6 +267,9 @@ void enterDebugMode(MecanumDrive &drive, XboxController &xbox) {
       char debugCommand = Serial.read();
       if (debugCommand == 'q') {
         Serial.println(F("Exiting Debug Mode..."));
+        if (closedLoop) {
+          drive.setClosedLoopEnabled(true);
+        }
         break; // Exit debug mode
       }
 
@@ -191,6 +293,12 @@ void enterDebugMode(MecanumDrive &drive, XboxController &xbox) {
         // Re-enable Xbox controller inputs
         xbox.setDisabled(false);
       }
+      if (debugCommand == 'l') {
+        runLatencyCharacterization(drive, xbox, probe);
+      }
+      if (debugCommand == 'v') {
+        printVelocityTelemetry(drive);
+      }
       // Other debug commands...
     }
   }
@@ -4,8 +4,15 @@
 #include <Arduino.h>
 #include "MecanumDrive.h"
 #include "XboxController.h"
+#include "LatencyProbe.h"
 
 // Function to initialize the debug menu
-void enterDebugMode(MecanumDrive &drive, XboxController &xbox);
+void enterDebugMode(MecanumDrive &drive, XboxController &xbox, LatencyProbe &probe);
+
+// Print the latency distribution of every stage captured by the probe
+void printLatencyReport(const LatencyProbe &probe);
+
+// Replay the cardinal commands as scripted stick steps and print the latency report
+void runLatencyCharacterization(MecanumDrive &drive, XboxController &xbox, LatencyProbe &probe);
 
 #endif // DEBUG_MENU_H
\ No newline at end of file
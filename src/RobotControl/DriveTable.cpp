@@ -0,0 +1,182 @@
+#include "DriveTable.h"
+#include <EEPROM.h>
+#include <stddef.h>
+
+// EEPROM layout of the persisted tuning record
+// Bump DRIVE_TUNING_VERSION whenever DriveTuningRecord changes
+const int DRIVE_TUNING_EEPROM_ADDRESS = 0;
+const uint16_t DRIVE_TUNING_MAGIC = 0x4454; // "DT"
+const uint8_t DRIVE_TUNING_VERSION = 1;
+
+struct DriveTuningRecord {
+  uint16_t magic;
+  uint8_t version;
+  DriveTuning tuning;
+  uint8_t checksum;
+};
+
+// Snapped stick positions, ordered counter-clockwise starting East
+static const int8_t directionXs[DriveTable::DIRECTIONS] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int8_t directionYs[DriveTable::DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+// Constructor
+DriveTable::DriveTable() : saveCursor(0xFF) {
+  invalidate();
+}
+
+// Mark every entry stale and restart the rebuild from the first entry
+void DriveTable::invalidate() {
+  buildCursor = 0;
+}
+
+// Check if every entry has been rebuilt since the last invalidate()
+bool DriveTable::isReady() const {
+  return buildCursor >= DIRECTIONS * TURN_BINS;
+}
+
+// Get the direction and turn bin of the next entry to rebuild
+bool DriveTable::nextEntry(uint8_t &direction, uint8_t &turnBin) const {
+  if (isReady()) {
+    return false;
+  }
+  direction = buildCursor / TURN_BINS;
+  turnBin = buildCursor % TURN_BINS;
+  return true;
+}
+
+// Store the DAC codes of the entry returned by nextEntry()
+void DriveTable::storeEntry(const int16_t codes[CHANNELS]) {
+  if (isReady()) {
+    return;
+  }
+  int16_t *entry = entries[buildCursor / TURN_BINS][buildCursor % TURN_BINS];
+  for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+    entry[channel] = codes[channel];
+  }
+  buildCursor++;
+}
+
+// Interpolate the DAC codes for a direction and a ramped turn in [-1, 1]
+void DriveTable::lookup(uint8_t direction, float turn, int16_t codes[CHANNELS]) const {
+  bool mirrored = turn < 0;
+  turn = constrain(abs(turn), 0.0f, 1.0f);
+
+  // Position along the turn axis in 1/256ths of a bin
+  uint16_t position = turn * (TURN_BINS - 1) * 256;
+  uint8_t bin = position >> 8;
+  uint16_t fraction = position & 0xFF;
+  if (bin >= TURN_BINS - 1) {
+    bin = TURN_BINS - 2;
+    fraction = 256;
+  }
+
+  const int16_t *low = entries[direction][bin];
+  const int16_t *high = entries[direction][bin + 1];
+  int16_t interpolated[CHANNELS];
+  for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+    int32_t delta = (int32_t)(high[channel] - low[channel]) * fraction;
+    interpolated[channel] = low[channel] + (int16_t)(delta / 256);
+  }
+
+  // A negative turn swaps diagonal wheel pairs, and the right-side channels
+  // are inverted in move(), so every code also flips sign
+  for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+    codes[channel] = mirrored ? -interpolated[CHANNELS - 1 - channel] : interpolated[channel];
+  }
+}
+
+// Map a deadzoned stick position to one of the eight snapped directions
+uint8_t DriveTable::directionIndex(float x, float y) {
+  // A centred stick snaps East
+  if (x == 0 && y == 0) {
+    return 0;
+  }
+
+  // tan(22.5 degrees) separates the cardinal sectors from the diagonal ones
+  const float sectorSlope = 0.41421356;
+  float absX = abs(x);
+  float absY = abs(y);
+
+  if (absY < absX * sectorSlope) { // East or West
+    return x > 0 ? 0 : 4;
+  }
+  if (absX <= absY * sectorSlope) { // North or South
+    return y > 0 ? 2 : 6;
+  }
+  if (x > 0) { // Northeast or Southeast
+    return y > 0 ? 1 : 7;
+  }
+  return y > 0 ? 3 : 5; // Northwest or Southwest
+}
+
+// Snapped stick position for a direction index
+float DriveTable::directionX(uint8_t direction) { return directionXs[direction]; }
+float DriveTable::directionY(uint8_t direction) { return directionYs[direction]; }
+
+// Ramped turn value sampled by a turn bin
+float DriveTable::turnForBin(uint8_t turnBin) {
+  return turnBin * (1.0f / (TURN_BINS - 1));
+}
+
+// Checksum over the record, excluding the checksum byte itself
+static uint8_t tuningChecksum(const DriveTuningRecord &record) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+  uint8_t sum = 0;
+  for (size_t i = 0; i < offsetof(DriveTuningRecord, checksum); i++) {
+    sum = (sum << 1 | sum >> 7) ^ bytes[i];
+  }
+  return sum;
+}
+
+// Load tuning from EEPROM, returns false if no valid record is stored
+bool DriveTable::loadTuning(DriveTuning &tuning) {
+  DriveTuningRecord record;
+  EEPROM.get(DRIVE_TUNING_EEPROM_ADDRESS, record);
+
+  if (record.magic != DRIVE_TUNING_MAGIC || record.version != DRIVE_TUNING_VERSION ||
+      record.checksum != tuningChecksum(record)) {
+    return false;
+  }
+
+  tuning = record.tuning;
+  return true;
+}
+
+// Build the EEPROM record for a tuning
+static void buildRecord(const DriveTuning &tuning, DriveTuningRecord &record) {
+  memset(&record, 0, sizeof(record));
+  record.magic = DRIVE_TUNING_MAGIC;
+  record.version = DRIVE_TUNING_VERSION;
+  record.tuning = tuning;
+  record.checksum = tuningChecksum(record);
+}
+
+// Queue tuning to be saved to EEPROM by serviceSave()
+void DriveTable::saveTuning(const DriveTuning &tuning) {
+  // Restart from the first byte, so the record only validates once it has
+  // been written in full
+  pendingTuning = tuning;
+  saveCursor = 0;
+}
+
+// Write the next byte of a queued save if the EEPROM is idle
+void DriveTable::serviceSave() {
+  if (!isSavePending() || !eeprom_is_ready()) {
+    return;
+  }
+
+  DriveTuningRecord record;
+  buildRecord(pendingTuning, record);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+
+  // EEPROM.update() only starts a write if the byte changed
+  EEPROM.update(DRIVE_TUNING_EEPROM_ADDRESS + saveCursor, bytes[saveCursor]);
+  if (++saveCursor >= sizeof(record)) {
+    saveCursor = 0xFF;
+  }
+}
+
+// Check if a queued save has not been fully written yet
+bool DriveTable::isSavePending() const {
+  return saveCursor != 0xFF;
+}
@@ -0,0 +1,82 @@
+#ifndef DRIVETABLE_H
+#define DRIVETABLE_H
+
+#include <Arduino.h>
+
+// Tunable parameters of the stick-to-wheel pipeline
+struct DriveTuning {
+  float rampFactor;    // Exponent applied by MecanumDrive::applyRamp()
+  float strafingScale; // Scale applied to the X axis after the ramp
+};
+
+// Precomputed stick-to-wheel lookup table.
+//
+// After snapToCardinalDirection() the left stick only contributes one of eight
+// directions, so the whole move() pipeline reduces to a function of
+// (direction, turn). The table stores the signed DAC code for each of the four
+// channels at TURN_BINS evenly spaced values of the ramped turn, applyRamp(turn)
+// in [0, 1], and interpolates between them. The mix is linear in the ramped
+// turn except where normalization kicks in, so the error stays within 10 codes
+// (0.25% of full scale) across the accepted ramp range of 0.5 to 4.0.
+// Negative turns reuse the same entries: mirroring the turn swaps front-left
+// with rear-right and front-right with rear-left.
+// The table is filled one entry at a time by MecanumDrive::serviceLookupTable()
+// and is only used once every entry has been rebuilt.
+class DriveTable {
+public:
+  static const uint8_t DIRECTIONS = 8;
+  static const uint8_t TURN_BINS = 17;
+  static const uint8_t CHANNELS = 4;
+
+  DriveTable();
+
+  // Mark every entry stale and restart the rebuild from the first entry
+  void invalidate();
+
+  // Check if every entry has been rebuilt since the last invalidate()
+  bool isReady() const;
+
+  // Get the direction and turn bin of the next entry to rebuild
+  // Returns false if the table is already complete
+  bool nextEntry(uint8_t &direction, uint8_t &turnBin) const;
+
+  // Store the DAC codes of the entry returned by nextEntry()
+  void storeEntry(const int16_t codes[CHANNELS]);
+
+  // Interpolate the DAC codes for a direction and a ramped turn in [-1, 1]
+  void lookup(uint8_t direction, float turn, int16_t codes[CHANNELS]) const;
+
+  // Map a deadzoned stick position to one of the eight snapped directions
+  // MecanumDrive::snapToCardinalDirection() uses it too, so both paths agree
+  static uint8_t directionIndex(float x, float y);
+
+  // Snapped stick position for a direction index
+  static float directionX(uint8_t direction);
+  static float directionY(uint8_t direction);
+
+  // Ramped turn value sampled by a turn bin
+  static float turnForBin(uint8_t turnBin);
+
+  // Load tuning from EEPROM, returns false if no valid record is stored
+  static bool loadTuning(DriveTuning &tuning);
+
+  // Queue tuning to be saved to EEPROM by serviceSave()
+  void saveTuning(const DriveTuning &tuning);
+
+  // Write the next byte of a queued save if the EEPROM is idle (call in the
+  // main loop). A byte write takes 3.3 ms, so the record is never written in
+  // one go while driving.
+  void serviceSave();
+
+  // Check if a queued save has not been fully written yet
+  bool isSavePending() const;
+
+private:
+  int16_t entries[DIRECTIONS][TURN_BINS][CHANNELS];
+  uint16_t buildCursor; // Index of the next entry to rebuild
+
+  DriveTuning pendingTuning;
+  uint8_t saveCursor; // Next record byte to write, 0xFF when idle
+};
+
+#endif // DRIVETABLE_H
@@ -0,0 +1,46 @@
+#include "FlightRecorder.h"
+
+const uint16_t FLIGHT_RECORDER_MAGIC = 0xF17E;
+
+// Not cleared by the C runtime at startup
+FlightRecorder flightRecorder __attribute__((section(".noinit")));
+
+// Validate the trace left by the previous run, or start a fresh one
+bool FlightRecorder::begin(uint8_t resetFlags) {
+  bool survived = magic == FLIGHT_RECORDER_MAGIC;
+  if (!survived) {
+    // Power-on: SRAM holds garbage
+    magic = FLIGHT_RECORDER_MAGIC;
+    head = 0;
+  }
+  record(FLIGHT_BOOT, resetFlags);
+  return survived;
+}
+
+// Print a value as fixed-width hex
+static void printHex(Print &out, uint32_t value, uint8_t digits) {
+  for (int8_t shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+    out.print((value >> shift) & 0x0F, HEX);
+  }
+}
+
+// Print the trace oldest first, one hex line per event
+void FlightRecorder::dump(Print &out) const {
+  uint16_t count = head < RECORDS ? head : RECORDS;
+
+  out.print(F("FLIGHT RECORDER BEGIN "));
+  out.println(count);
+  for (uint16_t i = head - count; i != head; i++) {
+    const FlightRecord &entry = records[i & (RECORDS - 1)];
+    out.print(F("FR "));
+    printHex(out, entry.timeMs, 4);
+    out.print(' ');
+    printHex(out, entry.type, 2);
+    out.print(' ');
+    printHex(out, entry.arg, 2);
+    out.print(' ');
+    printHex(out, entry.data, 8);
+    out.println();
+  }
+  out.println(F("FLIGHT RECORDER END"));
+}
@@ -0,0 +1,68 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <Arduino.h>
+
+// Event types, mirrored by tools/flight_decode.py
+enum FlightEventType {
+  FLIGHT_BOOT = 1,         // arg: MCUSR reset flags
+  FLIGHT_STATE = 2,        // arg: FlightState
+  FLIGHT_FAULT = 3,        // arg: bit per motor fault pin that is LOW
+  FLIGHT_DEADMAN = 4,      // arg: 1 held, 0 released
+  FLIGHT_DAC = 5,          // arg: bit per negative channel, data: |code| >> 4 per channel, A in the low byte
+                           // At most every 250 ms while driving, plus every start and stop
+  FLIGHT_LOOP_OVERRUN = 6  // data: loop duration in ms
+};
+
+// Values of FLIGHT_STATE events
+enum FlightState {
+  FLIGHT_STATE_WAIT_BUTTON = 1,
+  FLIGHT_STATE_RUNNING = 2,
+  FLIGHT_STATE_FAULT = 3,
+  FLIGHT_STATE_FAULT_CLEARED = 4,
+  FLIGHT_STATE_INIT_FAILED = 5,
+  FLIGHT_STATE_DEBUG = 6,
+  FLIGHT_STATE_HOST_CONTROL = 7,
+  FLIGHT_STATE_MENU = 8
+};
+
+struct FlightRecord {
+  uint16_t timeMs; // Low 16 bits of millis()
+  uint8_t type;
+  uint8_t arg;
+  uint32_t data;
+};
+
+// Circular event trace kept in .noinit RAM, so it survives any reset that
+// keeps SRAM powered (watchdog, reset button) and can be dumped after the
+// next boot. Must stay a plain aggregate: a constructor would clear the trace.
+class FlightRecorder {
+public:
+  static const uint8_t RECORDS = 64; // Power of two
+
+  // Validate the trace left by the previous run, or start a fresh one
+  // Returns true if a previous trace survived the reset
+  bool begin(uint8_t resetFlags);
+
+  // Append an event, overwriting the oldest once the trace is full
+  inline void record(uint8_t type, uint8_t arg, uint32_t data = 0) {
+    FlightRecord &entry = records[head & (RECORDS - 1)];
+    if (++head == 0) head = RECORDS; // Stay "full" across the 16-bit wrap
+    entry.timeMs = millis();
+    entry.type = type;
+    entry.arg = arg;
+    entry.data = data;
+  }
+
+  // Print the trace oldest first, one hex line per event
+  void dump(Print &out) const;
+
+private:
+  uint16_t magic;
+  uint16_t head; // Free-running, the next slot is head % RECORDS
+  FlightRecord records[RECORDS];
+};
+
+extern FlightRecorder flightRecorder;
+
+#endif // FLIGHTRECORDER_H
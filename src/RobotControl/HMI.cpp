@@ -1,8 +1,9 @@
 #include "HMI.h"
+#include "FlightRecorder.h"
 
 HMI::HMI(int redPin, int greenPin, int motorFaultPins[4]) 
     : redPin(redPin), greenPin(greenPin), redState(false), greenState(false),
-      lastRedToggle(0), lastGreenToggle(0), redBlinking(false), greenBlinking(false) {
+      lastRedToggle(0), lastGreenToggle(0), redBlinking(false), greenBlinking(false), lastFaultMask(0) {
     for (int i = 0; i < 4; i++) {
         this->motorFaultPins[i] = motorFaultPins[i];
     }
@@ -64,13 +65,24 @@ bool HMI::motorInFault() {
     //     Serial.print(F(": "));
     //     Serial.println(digitalRead(motorFaultPins[i]) == LOW ? "FAULT" : "OK");
     // }
+    uint8_t faultMask = 0;
     for (int i = 0; i < 4; i++) {
         if (digitalRead(motorFaultPins[i]) == LOW) {
-            this->setGreen(false); 
-            this->blinkRed();
-            return true;
+            faultMask |= 1 << i;
         }
     }
+
+    // Record fault pin edges
+    if (faultMask != lastFaultMask) {
+        flightRecorder.record(FLIGHT_FAULT, faultMask);
+        lastFaultMask = faultMask;
+    }
+
+    if (faultMask) {
+        this->setGreen(false); 
+        this->blinkRed();
+        return true;
+    }
     this->setRed(true); // Stop blinking red LED if no fault
     return false; // No faults
 }
\ No newline at end of file
@@ -25,6 +25,7 @@ private:
     unsigned long lastGreenToggle; // Last time the green LED toggled
     bool redBlinking;              // Whether the red LED is blinking
     bool greenBlinking;            // Whether the green LED is blinking
+    uint8_t lastFaultMask;         // Fault pins seen LOW on the previous check
     const unsigned long blinkInterval = 1000; // Blink interval in milliseconds
 };
 
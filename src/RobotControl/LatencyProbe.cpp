@@ -0,0 +1,131 @@
+#include "LatencyProbe.h"
+
+// Constructor
+LatencyStats::LatencyStats() {
+  reset();
+}
+
+// Clear all samples
+void LatencyStats::reset() {
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    buckets[i] = 0;
+  }
+  count = 0;
+  minUs = 0xFFFFFFFF;
+  maxUs = 0;
+  sumUs = 0;
+}
+
+// Add one latency sample
+void LatencyStats::record(uint32_t latencyUs) {
+  if (count == 0xFFFF) {
+    return; // Saturated, keep the distribution consistent
+  }
+
+  uint32_t bucket = latencyUs / BUCKET_WIDTH_US;
+  if (bucket >= BUCKETS) {
+    bucket = BUCKETS - 1;
+  }
+  buckets[bucket]++;
+
+  count++;
+  sumUs += latencyUs;
+  if (latencyUs < minUs) minUs = latencyUs;
+  if (latencyUs > maxUs) maxUs = latencyUs;
+}
+
+uint16_t LatencyStats::getCount() const { return count; }
+uint32_t LatencyStats::getMin() const { return count ? minUs : 0; }
+uint32_t LatencyStats::getMax() const { return maxUs; }
+uint32_t LatencyStats::getMean() const { return count ? sumUs / count : 0; }
+
+// Upper bound of the bucket holding the given percentile (0-100)
+uint32_t LatencyStats::getPercentile(uint8_t percentile) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  uint32_t target = ((uint32_t)count * percentile + 99) / 100;
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < BUCKETS - 1; i++) {
+    cumulative += buckets[i];
+    if (cumulative >= target) {
+      uint32_t upper = (uint32_t)(i + 1) * BUCKET_WIDTH_US;
+      return upper < maxUs ? upper : maxUs;
+    }
+  }
+  return maxUs; // Falls in the overflow bucket
+}
+
+// Constructor
+LatencyProbe::LatencyProbe(Clock clock)
+    : clock(clock), armed(false), sampleOpen(false), stagesMarked(0), inputTime(0) {}
+
+// Start capturing samples
+void LatencyProbe::arm() {
+  sampleOpen = false;
+  armed = true;
+}
+
+// Stop capturing samples
+void LatencyProbe::disarm() {
+  armed = false;
+  sampleOpen = false;
+}
+
+bool LatencyProbe::isArmed() const {
+  return armed;
+}
+
+// Clear all statistics
+void LatencyProbe::reset() {
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    stats[i].reset();
+  }
+  sampleOpen = false;
+}
+
+// Timestamp a stage
+void LatencyProbe::mark(Stage stage) {
+  if (!armed) {
+    return;
+  }
+
+  unsigned long now = clock();
+
+  if (stage == STAGE_INPUT) {
+    // A new input supersedes one that never reached the DAC
+    inputTime = now;
+    sampleOpen = true;
+    stagesMarked = 1 << STAGE_INPUT;
+    stats[STAGE_INPUT].record(0);
+    return;
+  }
+
+  if (!sampleOpen || (stagesMarked & (1 << stage))) {
+    return;
+  }
+
+  stagesMarked |= 1 << stage;
+  stats[stage].record(now - inputTime);
+
+  if (stage == STAGE_DAC) {
+    sampleOpen = false;
+  }
+}
+
+// Latency from STAGE_INPUT to the given stage
+const LatencyStats &LatencyProbe::getStats(Stage stage) const {
+  return stats[stage];
+}
+
+// Printable name of a stage
+const char *LatencyProbe::stageName(Stage stage) {
+  switch (stage) {
+    case STAGE_INPUT: return "input";
+    case STAGE_UPDATE: return "update";
+    case STAGE_MIX: return "move";
+    case STAGE_DAC: return "dac";
+    default: return "?";
+  }
+}
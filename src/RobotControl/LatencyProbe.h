@@ -0,0 +1,83 @@
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include <stdint.h>
+
+// Latency distribution in fixed-width microsecond buckets
+class LatencyStats {
+public:
+  static const uint8_t BUCKETS = 32;
+  static const uint16_t BUCKET_WIDTH_US = 250; // Last bucket collects everything above
+
+  LatencyStats();
+
+  // Clear all samples
+  void reset();
+
+  // Add one latency sample
+  void record(uint32_t latencyUs);
+
+  uint16_t getCount() const;
+  uint32_t getMin() const;
+  uint32_t getMax() const;
+  uint32_t getMean() const;
+
+  // Upper bound of the bucket holding the given percentile (0-100)
+  uint32_t getPercentile(uint8_t percentile) const;
+
+private:
+  uint16_t buckets[BUCKETS];
+  uint16_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t sumUs;
+};
+
+// Timestamps each stage from a new stick input to the DAC write and
+// accumulates the latency of every stage relative to the input.
+//
+// The clock is injected so the probe also runs in a host build with a fake
+// clock; on the board it is micros().
+class LatencyProbe {
+public:
+  enum Stage {
+    STAGE_INPUT,  // New controller report (or scripted step) available
+    STAGE_UPDATE, // XboxController::update() done
+    STAGE_MIX,    // MecanumDrive::move() computed the motor powers
+    STAGE_DAC,    // Last MCP4728 channel write complete
+    STAGE_COUNT
+  };
+
+  typedef unsigned long (*Clock)();
+
+  LatencyProbe(Clock clock);
+
+  // Start or stop capturing samples
+  void arm();
+  void disarm();
+  bool isArmed() const;
+
+  // Clear all statistics
+  void reset();
+
+  // Timestamp a stage
+  // STAGE_INPUT opens a sample, STAGE_DAC closes it; other stages are
+  // ignored unless a sample is open
+  void mark(Stage stage);
+
+  // Latency from STAGE_INPUT to the given stage
+  const LatencyStats &getStats(Stage stage) const;
+
+  // Printable name of a stage
+  static const char *stageName(Stage stage);
+
+private:
+  Clock clock;
+  bool armed;
+  bool sampleOpen;
+  uint8_t stagesMarked; // Bit per stage already stamped in the open sample
+  unsigned long inputTime;
+  LatencyStats stats[STAGE_COUNT];
+};
+
+#endif // LATENCYPROBE_H
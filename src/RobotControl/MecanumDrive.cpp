@@ -1,7 +1,8 @@
 #include "MecanumDrive.h"
 
 // Constructor
-MecanumDrive::MecanumDrive() : motorsEnabled(false) {}
+MecanumDrive::MecanumDrive()
+    : velocityController(controlPeriodUs, fullScaleEncoderCounts(), 10240, 2048), motorsEnabled(false) {}
 
 // Initialize the DAC and motor pins
 bool MecanumDrive::initialize() {
@@ -25,6 +26,8 @@ bool MecanumDrive::initialize() {
   // Set enable pins LOW
   disableMotors();
 
+  encoders.begin();
+
   return true;
 }
 
@@ -34,6 +37,54 @@ void MecanumDrive::resetDACOutputs() {
   dac.setChannelValue(MCP4728_CHANNEL_B, 0);
   dac.setChannelValue(MCP4728_CHANNEL_C, 0);
   dac.setChannelValue(MCP4728_CHANNEL_D, 0);
+
+  for (int channel = 0; channel < 4; channel++) {
+    if (dacCodes[channel] != 0) {
+      dacCodes[channel] = 0;
+      dacFrameChanged = true;
+    }
+  }
+  recordDacFrame();
+}
+
+// Record the DAC frame in the flight recorder if any channel changed
+void MecanumDrive::recordDacFrame() {
+  if (!dacFrameChanged) {
+    return;
+  }
+
+  bool stopped = true;
+  for (int channel = 0; channel < 4; channel++) {
+    if (dacCodes[channel] != 0) stopped = false;
+  }
+
+  // Hold back changes within the interval; the latest frame is recorded
+  // once it has passed
+  unsigned long now = millis();
+  if (stopped == dacRecordedStopped && now - lastDacRecordMs < dacRecordIntervalMs) {
+    return;
+  }
+  dacFrameChanged = false;
+  dacRecordedStopped = stopped;
+  lastDacRecordMs = now;
+
+  // Sign bit and top 8 bits of the magnitude per channel
+  uint8_t signs = 0;
+  uint32_t magnitudes = 0;
+  for (int channel = 0; channel < 4; channel++) {
+    if (dacCodes[channel] < 0) signs |= 1 << channel;
+    magnitudes |= (uint32_t)(abs(dacCodes[channel]) >> 4) << (8 * channel);
+  }
+  flightRecorder.record(FLIGHT_DAC, signs, magnitudes);
+}
+
+// Timestamp the DAC stage after move() wrote the outputs
+// In closed loop move() only sets feed-forward, and serviceVelocityLoop()
+// stamps the stage once it writes the DAC
+void MecanumDrive::markDacWritten() {
+  if (latencyProbe && !closedLoopEnabled) {
+    latencyProbe->mark(LatencyProbe::STAGE_DAC);
+  }
 }
 
 // Helper method to set the state of all motor enable pins
@@ -53,6 +104,7 @@ void MecanumDrive::enableMotors() {
 // Disable motors
 void MecanumDrive::disableMotors() {
   this->resetDACOutputs(); // Reset DAC outputs to 0
+  velocityController.reset();
   setMotorEnableState(false);
   motorsEnabled = false; // Update the state
 }
@@ -93,71 +145,110 @@ void MecanumDrive::disableRearRightMotor() {
 
 // Calculate motor powers and set motor directions and DAC outputs
 void MecanumDrive::move(float x, float y, float turn) {
+  if (isLookupTableReady()) {
+    int16_t codes[DriveTable::CHANNELS];
+    lookupTable.lookup(DriveTable::directionIndex(x, y), applyRamp(turn), codes);
+
+    frontLeftPower = codes[0] / 4095.0;
+    frontRightPower = -codes[1] / 4095.0;
+    rearLeftPower = codes[2] / 4095.0;
+    rearRightPower = -codes[3] / 4095.0;
+    if (latencyProbe) latencyProbe->mark(LatencyProbe::STAGE_MIX);
+
+    setMotorCode(frontLeftDirPin, codes[0], MCP4728_CHANNEL_A);
+    setMotorCode(frontRightDirPin, codes[1], MCP4728_CHANNEL_B);
+    setMotorCode(rearLeftDirPin, codes[2], MCP4728_CHANNEL_C);
+    setMotorCode(rearRightDirPin, codes[3], MCP4728_CHANNEL_D);
+    markDacWritten();
+    recordDacFrame();
+    return;
+  }
+
   snapToCardinalDirection(x, y);
 
-  // Apply ramp scaling to joystick inputs
-  x = applyRamp(x);
-  y = applyRamp(y);
-  turn = applyRamp(turn);
+  float powers[4];
+  computeMotorPowers(x, y, turn, powers);
+  frontLeftPower = powers[0];
+  frontRightPower = powers[1];
+  rearLeftPower = powers[2];
+  rearRightPower = powers[3];
+  if (latencyProbe) latencyProbe->mark(LatencyProbe::STAGE_MIX);
 
-  // Scale down strafing speed
-  const float strafingScale = 0.5; // Adjust this value to control strafing speed (e.g., 0.5 for 50% speed)
-  x *= strafingScale;
+  // Set motor directions and DAC outputs
+  setMotor(frontLeftDirPin, frontLeftPower, MCP4728_CHANNEL_A);
+  setMotor(frontRightDirPin, -frontRightPower, MCP4728_CHANNEL_B);
+  setMotor(rearLeftDirPin, rearLeftPower, MCP4728_CHANNEL_C);
+  setMotor(rearRightDirPin, -rearRightPower, MCP4728_CHANNEL_D);
+  markDacWritten();
+  recordDacFrame();
+}
 
-  calculateMotorPowers(x, y, turn);
+// Move with an analog setpoint in [-1, 1], keeping its direction and magnitude
+void MecanumDrive::moveAnalog(float x, float y, float turn) {
+  float powers[4];
+  computeMotorPowers(constrain(x, -1.0f, 1.0f), constrain(y, -1.0f, 1.0f), constrain(turn, -1.0f, 1.0f), powers);
+  frontLeftPower = powers[0];
+  frontRightPower = powers[1];
+  rearLeftPower = powers[2];
+  rearRightPower = powers[3];
+  if (latencyProbe) latencyProbe->mark(LatencyProbe::STAGE_MIX);
+
+  // Same channel signs as move()
+  setMotor(frontLeftDirPin, frontLeftPower, MCP4728_CHANNEL_A);
+  setMotor(frontRightDirPin, -frontRightPower, MCP4728_CHANNEL_B);
+  setMotor(rearLeftDirPin, rearLeftPower, MCP4728_CHANNEL_C);
+  setMotor(rearRightDirPin, -rearRightPower, MCP4728_CHANNEL_D);
+  markDacWritten();
+  recordDacFrame();
+}
 
-  // Set motor directions and DAC outputs
+// Drive each wheel directly with a power in [-1, 1], bypassing the stick shaping
+void MecanumDrive::setWheelPowers(float frontLeft, float frontRight, float rearLeft, float rearRight) {
+  frontLeftPower = constrain(frontLeft, -1.0f, 1.0f);
+  frontRightPower = constrain(frontRight, -1.0f, 1.0f);
+  rearLeftPower = constrain(rearLeft, -1.0f, 1.0f);
+  rearRightPower = constrain(rearRight, -1.0f, 1.0f);
+
+  // Same channel signs as move()
   setMotor(frontLeftDirPin, frontLeftPower, MCP4728_CHANNEL_A);
   setMotor(frontRightDirPin, -frontRightPower, MCP4728_CHANNEL_B);
   setMotor(rearLeftDirPin, rearLeftPower, MCP4728_CHANNEL_C);
   setMotor(rearRightDirPin, -rearRightPower, MCP4728_CHANNEL_D);
+  recordDacFrame();
+}
+
+// Apply ramp and strafing scale to the inputs and mix them into motor powers
+void MecanumDrive::computeMotorPowers(float x, float y, float turn, float powers[4]) {
+  computeRampedMotorPowers(x, y, applyRamp(turn), powers);
+}
+
+// Same as computeMotorPowers() for a turn input that is already ramped
+void MecanumDrive::computeRampedMotorPowers(float x, float y, float rampedTurn, float powers[4]) {
+  float turn = rampedTurn;
+
+  // Apply ramp scaling to joystick inputs
+  x = applyRamp(x);
+  y = applyRamp(y);
+
+  // Scale down strafing speed
+  x *= tuning.strafingScale;
+
+  calculateMotorPowers(x, y, turn, powers);
 }
 
 // Apply ramp scaling to joystick input
 float MecanumDrive::applyRamp(float input) {
   // Ramp factor controls the non-linearity (e.g., 1.5 for cubic scaling)
-  const float rampFactor = 2.0;
-
   // Preserve the sign of the input
-  return (input >= 0 ? 1 : -1) * pow(abs(input), rampFactor);
+  return (input >= 0 ? 1 : -1) * pow(abs(input), tuning.rampFactor);
 }
 
 // Snap joystick input to cardinal or diagonal directions
 void MecanumDrive::snapToCardinalDirection(float &x, float &y) {
-  // Calculate the angle of the joystick input
-  float angle = atan2(y, x) * 180 / PI; // Convert radians to degrees
-
-  // Normalize the angle to the range [0, 360)
-  if (angle < 0) {
-    angle += 360;
-  }
-
-  // Snap to the nearest cardinal or diagonal direction
-  if (angle >= 22.5 && angle < 67.5) { // Northeast
-    x = 1;
-    y = 1;
-  } else if (angle >= 67.5 && angle < 112.5) { // North
-    x = 0;
-    y = 1;
-  } else if (angle >= 112.5 && angle < 157.5) { // Northwest
-    x = -1;
-    y = 1;
-  } else if (angle >= 157.5 && angle < 202.5) { // West
-    x = -1;
-    y = 0;
-  } else if (angle >= 202.5 && angle < 247.5) { // Southwest
-    x = -1;
-    y = -1;
-  } else if (angle >= 247.5 && angle < 292.5) { // South
-    x = 0;
-    y = -1;
-  } else if (angle >= 292.5 && angle < 337.5) { // Southeast
-    x = 1;
-    y = -1;
-  } else { // East
-    x = 1;
-    y = 0;
-  }
+  // Same sectors as the lookup table, a centred stick snaps East
+  uint8_t direction = DriveTable::directionIndex(x, y);
+  x = DriveTable::directionX(direction);
+  y = DriveTable::directionY(direction);
 }
 
 // Getter methods for motor power values
@@ -167,34 +258,54 @@ float MecanumDrive::getRearLeft() const { return rearLeftPower; }
 float MecanumDrive::getRearRight() const { return rearRightPower; }
 
 // Calculate motor powers based on joystick inputs
-void MecanumDrive::calculateMotorPowers(float x, float y, float turn) {
-  frontLeftPower = y + x + turn;
-  frontRightPower = y - x - turn;
-  rearLeftPower = y - x + turn;
-  rearRightPower = y + x - turn;
+void MecanumDrive::calculateMotorPowers(float x, float y, float turn, float powers[4]) {
+  powers[0] = y + x + turn;
+  powers[1] = y - x - turn;
+  powers[2] = y - x + turn;
+  powers[3] = y + x - turn;
 
   // Normalize motor powers to the range [-1, 1]
-  float maxPower = max(max(abs(frontLeftPower), abs(frontRightPower)),
-                       max(abs(rearLeftPower), abs(rearRightPower)));
+  float maxPower = max(max(abs(powers[0]), abs(powers[1])),
+                       max(abs(powers[2]), abs(powers[3])));
   if (maxPower > 1) {
-    frontLeftPower /= maxPower;
-    frontRightPower /= maxPower;
-    rearLeftPower /= maxPower;
-    rearRightPower /= maxPower;
+    for (int i = 0; i < 4; i++) {
+      powers[i] /= maxPower;
+    }
   }
 }
 
 // Set motor direction and output analog voltage
 void MecanumDrive::setMotor(int directionPin, float motorValue, MCP4728_channel_t channel) {
-  // Scale [-1, 1] to [0, 4095]
-  int dacValue = abs(motorValue * 4095);
-  dacValue = constrain(dacValue, 0, 4095);
+  setMotorCode(directionPin, powerToDacCode(motorValue), channel);
+}
+
+// Scale [-1, 1] to a signed DAC code in [-4095, 4095]
+int16_t MecanumDrive::powerToDacCode(float motorValue) {
+  int dacValue = motorValue * 4095;
+  return constrain(dacValue, -4095, 4095);
+}
+
+// Set motor direction and output a signed DAC code in [-4095, 4095]
+void MecanumDrive::setMotorCode(int directionPin, int16_t dacCode, MCP4728_channel_t channel) {
+  if (closedLoopEnabled) {
+    velocityController.setFeedForward(channel, dacCode);
+    return;
+  }
+  writeMotorCode(directionPin, dacCode, channel);
+}
 
+// Write a signed DAC code to a channel and its direction pin
+void MecanumDrive::writeMotorCode(int directionPin, int16_t dacCode, MCP4728_channel_t channel) {
   // Set direction: HIGH = CCW, LOW = CW
-  digitalWrite(directionPin, motorValue >= 0 ? LOW : HIGH);
+  digitalWrite(directionPin, dacCode >= 0 ? LOW : HIGH);
 
   // Set the corresponding MCP4728 channel output
-  dac.setChannelValue(channel, dacValue);
+  dac.setChannelValue(channel, abs(dacCode));
+
+  if (dacCodes[channel] != dacCode) {
+    dacCodes[channel] = dacCode;
+    dacFrameChanged = true;
+  }
 }
 
 // Set motor RPM and direction
@@ -239,11 +350,13 @@ void MecanumDrive::setMotorRPM(const String &motor, int rpm, bool forward) {
 
   // Use setMotor to handle direction and DAC output
   setMotor(directionPin, normalizedValue, channel);
+  recordDacFrame();
 }
 
 // Set the maximum RPM
 void MecanumDrive::setMaxRPM(int maxRPM) {
   this->maxRPM = maxRPM;
+  velocityController.setFullScaleCounts(fullScaleEncoderCounts());
   Serial.print(F("Maximum RPM set to: "));
   Serial.println(maxRPM);
 }
@@ -256,4 +369,163 @@ int MecanumDrive::getMaxRPM() const {
 // Check if motors are enabled
 bool MecanumDrive::areMotorsEnabled() {
   return motorsEnabled; // Return the current state of the motors
-}
\ No newline at end of file
+}
+
+// Load tuning from EEPROM, keeping the defaults if none is stored
+void MecanumDrive::loadTuning() {
+  DriveTuning stored;
+  if (DriveTable::loadTuning(stored)) {
+    tuning = stored;
+    lookupTable.invalidate();
+    Serial.println(F("Drive tuning loaded from EEPROM."));
+  } else {
+    Serial.println(F("No stored drive tuning, using defaults."));
+  }
+}
+
+// Getters for the stick-to-wheel tuning
+float MecanumDrive::getRampFactor() const { return tuning.rampFactor; }
+float MecanumDrive::getStrafingScale() const { return tuning.strafingScale; }
+
+// Set the ramp factor, rebuilding the lookup table and queueing an EEPROM save
+bool MecanumDrive::setRampFactor(float rampFactor) {
+  if (!(rampFactor >= 0.5 && rampFactor <= 4.0)) {
+    return false;
+  }
+  tuning.rampFactor = rampFactor;
+  lookupTable.saveTuning(tuning);
+  lookupTable.invalidate();
+  return true;
+}
+
+// Set the strafing scale, rebuilding the lookup table and queueing an EEPROM save
+bool MecanumDrive::setStrafingScale(float strafingScale) {
+  if (!(strafingScale >= 0.0 && strafingScale <= 1.0)) {
+    return false;
+  }
+  tuning.strafingScale = strafingScale;
+  lookupTable.saveTuning(tuning);
+  lookupTable.invalidate();
+  return true;
+}
+
+// Enable or disable the precomputed lookup table in move()
+void MecanumDrive::setLookupTableEnabled(bool enabled) {
+  lookupTableEnabled = enabled;
+}
+
+bool MecanumDrive::isLookupTableEnabled() const {
+  return lookupTableEnabled;
+}
+
+// Check if the lookup table is in use (enabled and fully rebuilt)
+bool MecanumDrive::isLookupTableReady() const {
+  return lookupTableEnabled && lookupTable.isReady();
+}
+
+// Attach a probe to timestamp move() (nullptr to detach)
+void MecanumDrive::setLatencyProbe(LatencyProbe *probe) {
+  latencyProbe = probe;
+}
+
+// Rebuild one lookup table entry and write one byte of a pending tuning save
+// (call in the main loop)
+// move() keeps using the direct computation until the last entry is rebuilt
+void MecanumDrive::serviceLookupTable() {
+  lookupTable.serviceSave();
+
+  uint8_t direction, turnBin;
+  if (!lookupTableEnabled || !lookupTable.nextEntry(direction, turnBin)) {
+    return;
+  }
+
+  float powers[4];
+  computeRampedMotorPowers(DriveTable::directionX(direction), DriveTable::directionY(direction),
+                           DriveTable::turnForBin(turnBin), powers);
+
+  // Same channel signs as move()
+  int16_t codes[DriveTable::CHANNELS] = {
+    powerToDacCode(powers[0]),
+    powerToDacCode(-powers[1]),
+    powerToDacCode(powers[2]),
+    powerToDacCode(-powers[3])
+  };
+  lookupTable.storeEntry(codes);
+}
+
+// Encoder counts per control tick at full DAC output (maxRPM)
+int16_t MecanumDrive::fullScaleEncoderCounts() const {
+  return (int32_t)maxRPM * encoderCountsPerRev * (controlPeriodUs / 1000) / 60000;
+}
+
+// Direction pin driven with a DAC channel
+int MecanumDrive::directionPinForChannel(uint8_t channel) const {
+  switch (channel) {
+    case MCP4728_CHANNEL_A: return frontLeftDirPin;
+    case MCP4728_CHANNEL_B: return frontRightDirPin;
+    case MCP4728_CHANNEL_C: return rearLeftDirPin;
+    default: return rearRightDirPin;
+  }
+}
+
+// Enable or disable closed-loop wheel velocity control
+void MecanumDrive::setClosedLoopEnabled(bool enabled) {
+  closedLoopEnabled = enabled;
+  if (!enabled) {
+    return; // Keep the last state for the telemetry printout
+  }
+
+  velocityController.reset();
+  velocityController.resetTelemetry();
+
+  // Drop counts gathered while the loop was off
+  int16_t deltas[QuadratureEncoders::WHEELS];
+  encoders.readDeltas(deltas);
+  lastControlTick = micros();
+}
+
+bool MecanumDrive::isClosedLoopEnabled() const {
+  return closedLoopEnabled;
+}
+
+// Run the velocity loop when its period has elapsed (call in the main loop)
+void MecanumDrive::serviceVelocityLoop() {
+  if (!closedLoopEnabled) {
+    return;
+  }
+
+  unsigned long now = micros();
+  unsigned long elapsed = now - lastControlTick;
+  if (elapsed < controlPeriodUs) {
+    return;
+  }
+
+  int16_t deltas[QuadratureEncoders::WHEELS];
+  encoders.readDeltas(deltas);
+
+  // The loop only runs when loop() gets here, so the counts cover the actual
+  // time since the last read rather than exactly one period
+  lastControlTick = now;
+
+  if (!motorsEnabled) {
+    return;
+  }
+
+  // After a stall the counts average over several setpoints, so skip the
+  // correction and output the feed-forward of the current setpoint instead of
+  // holding the last closed-loop output
+  bool stalled = elapsed >= 2 * controlPeriodUs;
+
+  for (uint8_t channel = 0; channel < QuadratureEncoders::WHEELS; channel++) {
+    int16_t dacCode = stalled ? velocityController.getFeedForward(channel)
+                              : velocityController.update(channel, deltas[channel], elapsed);
+    writeMotorCode(directionPinForChannel(channel), dacCode, static_cast<MCP4728_channel_t>(channel));
+  }
+  if (latencyProbe) latencyProbe->mark(LatencyProbe::STAGE_DAC);
+  recordDacFrame();
+}
+
+// Velocity loop gains and per-wheel tracking telemetry
+WheelVelocityController &MecanumDrive::getVelocityController() {
+  return velocityController;
+}
@@ -3,6 +3,11 @@
 
 #include <Arduino.h>
 #include <Adafruit_MCP4728.h>
+#include "DriveTable.h"
+#include "LatencyProbe.h"
+#include "QuadratureEncoders.h"
+#include "WheelVelocityController.h"
+#include "FlightRecorder.h"
 
 class MecanumDrive {
 public:
@@ -26,6 +31,13 @@ public:
   // Move the robot
   void move(float x, float y, float turn);
 
+  // Move with an analog setpoint in [-1, 1], keeping its direction and
+  // magnitude instead of snapping to full speed; (0, 0, 0) stops the base
+  void moveAnalog(float x, float y, float turn);
+
+  // Drive each wheel directly with a power in [-1, 1], bypassing the stick shaping
+  void setWheelPowers(float frontLeft, float frontRight, float rearLeft, float rearRight);
+
   // Set motor RPM and direction
   void setMotorRPM(const String &motor, int rpm, bool forward);
 
@@ -44,6 +56,47 @@ public:
   // Set motor direction and output analog voltage
   void setMotor(int directionPin, float motorValue, MCP4728_channel_t channel);
 
+  // Set motor direction and output a signed DAC code in [-4095, 4095]
+  // With the velocity loop enabled the code becomes the wheel's setpoint instead
+  void setMotorCode(int directionPin, int16_t dacCode, MCP4728_channel_t channel);
+
+  // Enable or disable closed-loop wheel velocity control
+  void setClosedLoopEnabled(bool enabled);
+  bool isClosedLoopEnabled() const;
+
+  // Run the velocity loop when its period has elapsed (call in the main loop)
+  void serviceVelocityLoop();
+
+  // Velocity loop gains and per-wheel tracking telemetry
+  WheelVelocityController &getVelocityController();
+
+  // Load tuning from EEPROM, keeping the defaults if none is stored
+  void loadTuning();
+
+  // Getters for the stick-to-wheel tuning
+  float getRampFactor() const;
+  float getStrafingScale() const;
+
+  // Set tuning values, rebuilding the lookup table and queueing an EEPROM save
+  // that serviceLookupTable() writes a byte at a time
+  // Returns false if the value is out of range
+  bool setRampFactor(float rampFactor);
+  bool setStrafingScale(float strafingScale);
+
+  // Enable or disable the precomputed lookup table in move()
+  void setLookupTableEnabled(bool enabled);
+  bool isLookupTableEnabled() const;
+
+  // Check if the lookup table is in use (enabled and fully rebuilt)
+  bool isLookupTableReady() const;
+
+  // Rebuild one lookup table entry and write one byte of a pending tuning
+  // save (call in the main loop)
+  void serviceLookupTable();
+
+  // Attach a probe to timestamp move() (nullptr to detach)
+  void setLatencyProbe(LatencyProbe *probe);
+
   // Individual motor enable/disable functions
   void enableFrontLeftMotor();
   void disableFrontLeftMotor();
@@ -74,6 +127,37 @@ private:
   // Maximum RPM (default is 50)
   int maxRPM = 75;
 
+  // Encoder counts per wheel revolution after quadrature decoding
+  const long encoderCountsPerRev = 4096;
+
+  // Fixed period of the velocity loop
+  const unsigned long controlPeriodUs = 10000;
+
+  // Closed-loop wheel velocity control
+  QuadratureEncoders encoders;
+  WheelVelocityController velocityController;
+  bool closedLoopEnabled = false;
+  unsigned long lastControlTick = 0;
+
+  // Stick-to-wheel tuning
+  DriveTuning tuning = {2.0, 0.5};
+
+  // Precomputed stick-to-wheel lookup table
+  DriveTable lookupTable;
+  bool lookupTableEnabled = false;
+
+  LatencyProbe *latencyProbe = nullptr;
+
+  // Signed DAC codes last written to each channel
+  int16_t dacCodes[4] = {0, 0, 0, 0};
+  bool dacFrameChanged = false;
+
+  // Flight recorder DAC frames while driving, so the velocity loop cannot
+  // flush the trace; starting and stopping are always recorded
+  const unsigned long dacRecordIntervalMs = 250;
+  unsigned long lastDacRecordMs = 0;
+  bool dacRecordedStopped = true;
+
   // Tracks the state of the motors
   bool motorsEnabled;
 
@@ -81,10 +165,35 @@ private:
   void setMotorEnableState(bool state);
 
   // Calculate motor powers based on joystick inputs
-  void calculateMotorPowers(float x, float y, float turn);
+  void calculateMotorPowers(float x, float y, float turn, float powers[4]);
+
+  // Apply ramp and strafing scale to snapped inputs and mix them into motor powers
+  void computeMotorPowers(float x, float y, float turn, float powers[4]);
+
+  // Same as computeMotorPowers() for a turn input that is already ramped
+  void computeRampedMotorPowers(float x, float y, float rampedTurn, float powers[4]);
+
+  float applyRamp(float input);
+  void snapToCardinalDirection(float &x, float &y);
+
+  // Scale [-1, 1] to a signed DAC code in [-4095, 4095]
+  static int16_t powerToDacCode(float motorValue);
+
+  // Write a signed DAC code to a channel and its direction pin
+  void writeMotorCode(int directionPin, int16_t dacCode, MCP4728_channel_t channel);
+
+  // Timestamp the DAC stage unless the velocity loop writes the DAC later
+  void markDacWritten();
+
+  // Record the DAC frame in the flight recorder if any channel changed,
+  // rate limited to dacRecordIntervalMs while driving
+  void recordDacFrame();
+
+  // Direction pin driven with a DAC channel
+  int directionPinForChannel(uint8_t channel) const;
 
-  float MecanumDrive::applyRamp(float input);
-  void MecanumDrive::snapToCardinalDirection(float &x, float &y);
+  // Encoder counts per control tick at full DAC output (maxRPM)
+  int16_t fullScaleEncoderCounts() const;
 
 };
 
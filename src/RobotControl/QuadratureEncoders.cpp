@@ -0,0 +1,65 @@
+#include "QuadratureEncoders.h"
+
+#if !defined(__AVR_ATmega2560__)
+#error "QuadratureEncoders uses the ATmega2560 port K pin change interrupt"
+#endif
+
+// Count change indexed by (previous BA << 2) | current BA
+static const int8_t quadratureTransitions[16] = {
+  0, -1, 1, 0,
+  1, 0, 0, -1,
+  -1, 0, 0, 1,
+  0, 1, -1, 0
+};
+
+// Set to flip a wheel whose encoder counts down when its DAC code is positive
+static const bool encoderInverted[QuadratureEncoders::WHEELS] = {false, false, false, false};
+
+static volatile int16_t encoderCounts[QuadratureEncoders::WHEELS];
+static volatile uint8_t lastPortState;
+
+ISR(PCINT2_vect) {
+  uint8_t portState = PINK;
+  uint8_t previous = lastPortState;
+  lastPortState = portState;
+
+  for (uint8_t wheel = 0; wheel < QuadratureEncoders::WHEELS; wheel++) {
+    uint8_t index = (previous & 0x03) << 2 | (portState & 0x03);
+    encoderCounts[wheel] += quadratureTransitions[index];
+    previous >>= 2;
+    portState >>= 2;
+  }
+}
+
+// Configure the pins and enable the pin change interrupt
+void QuadratureEncoders::begin() {
+  noInterrupts();
+  DDRK = 0x00;  // All of port K as inputs
+  PORTK = 0xFF; // With pull-ups
+  lastPortState = PINK;
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    encoderCounts[wheel] = 0;
+    lastCounts[wheel] = 0;
+  }
+  PCMSK2 = 0xFF;         // Every port K pin raises PCINT2
+  PCIFR = _BV(PCIF2);    // Drop any edge seen during setup
+  PCICR |= _BV(PCIE2);
+  interrupts();
+}
+
+// Get the counts accumulated by each wheel since the last call
+void QuadratureEncoders::readDeltas(int16_t deltas[WHEELS]) {
+  int16_t counts[WHEELS];
+  noInterrupts();
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    counts[wheel] = encoderCounts[wheel];
+  }
+  interrupts();
+
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    // Wrapping subtraction, so the 16-bit counters may overflow freely
+    int16_t delta = (int16_t)(counts[wheel] - lastCounts[wheel]);
+    lastCounts[wheel] = counts[wheel];
+    deltas[wheel] = encoderInverted[wheel] ? -delta : delta;
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef QUADRATUREENCODERS_H
+#define QUADRATUREENCODERS_H
+
+#include <Arduino.h>
+
+// Quadrature encoder capture for the four wheels on port K (A8-A15).
+//
+// Channel A/B pairs: front left A8/A9, front right A10/A11, rear left A12/A13,
+// rear right A14/A15. Every edge raises the port K pin change interrupt,
+// which decodes all four encoders from one port read.
+class QuadratureEncoders {
+public:
+  static const uint8_t WHEELS = 4;
+
+  // Configure the pins and enable the pin change interrupt
+  void begin();
+
+  // Get the counts accumulated by each wheel since the last call
+  void readDeltas(int16_t deltas[WHEELS]);
+
+private:
+  int16_t lastCounts[WHEELS] = {0, 0, 0, 0};
+};
+
+#endif // QUADRATUREENCODERS_H
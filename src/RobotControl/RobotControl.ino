@@ -5,6 +5,10 @@
 #include "MecanumDrive.h"
 #include "DebugMenu.h"
 #include "HMI.h"
+#include "LatencyProbe.h"
+#include "SetpointLink.h"
+#include "FlightRecorder.h"
+#include "UsbService.h"
 
 unsigned long lastPrintTime = 0;
 const unsigned long printInterval = 1000;
@@ -19,6 +23,7 @@ float motorPowerSum[4] = {0, 0, 0, 0}; // Accumulate motor powers for 4 motors
 unsigned long motorSampleCount = 0;   // Count the number of motor power samples
 
 USB Usb;
+UsbService usbService(Usb, 9, 4000); // MAX3421E INT on pin 9, poll at least every 4 ms
 
 XboxController xbox(&Usb);
 MecanumDrive mecanumDrive;
@@ -27,11 +32,37 @@ int redPin = 26; // Pin for red LED
 int greenPin = 24; // Pin for green LED
 
 HMI hmi(redPin, greenPin, motorFaultPins); // Pass motor fault pins to the HMI constructor
+LatencyProbe latencyProbe(micros); // Stick-to-DAC latency characterization
+SetpointLink setpointLink;         // Binary setpoint channel for host-computer control
+bool hostControlActive = false;    // Serial carries setpoint frames instead of menu commands
+
+const unsigned long loopOverrunMs = 20; // Loops slower than this are recorded in the flight recorder
+unsigned long lastLoopStart = 0;
+
+// Tuning command waiting for its value, read one character per loop so the control loop never stalls
+char pendingTuningCommand = '\0';
+char tuningInput[16];
+uint8_t tuningInputLength = 0;
 
 void setup() {
+  // Capture the reset cause before anything else
+  uint8_t resetFlags = MCUSR;
+  MCUSR = 0;
+  bool traceSurvived = flightRecorder.begin(resetFlags);
+
   Serial.begin(115200);
   while (!Serial);
 
+  if (traceSurvived) {
+    Serial.println(F("Flight recorder trace from before the reset:"));
+    flightRecorder.dump(Serial);
+  }
+
+  mecanumDrive.loadTuning();
+
+  xbox.setLatencyProbe(&latencyProbe);
+  mecanumDrive.setLatencyProbe(&latencyProbe);
+
   hmi.begin();
   hmi.blinkRed();
 
@@ -42,9 +73,13 @@ void setup() {
     }
   }
   Serial.println(F("XBOX USB Library Started"));
+  usbService.begin();
 
   hmi.setRed(true);
   xbox.setLedRotating();
+
+  // Time spent in setup is not a control-loop overrun
+  lastLoopStart = millis();
 }
 
 bool waitForXboxButton() {
@@ -52,7 +87,7 @@ bool waitForXboxButton() {
   bool buttonHeld = false;
 
   while (true) {
-    Usb.Task();
+    usbService.service();
 
     if (xbox.isConnected()) {
       if (xbox.getXBoxButtonPressed()) {
@@ -83,11 +118,155 @@ void printMainMenu() {
     Serial.println(F("  [p] Toggle Serial Printing"));
     Serial.println(F("  [h] Display this Help Menu"));
     Serial.println(F("  [s] Print System Status"));
+    Serial.println(F("  [t] Toggle Drive Lookup Table"));
+    Serial.println(F("  [r] Set Ramp Factor (0.5 - 4.0)"));
+    Serial.println(F("  [k] Set Strafing Scale (0.0 - 1.0)"));
+    Serial.println(F("  [l] Toggle Live Latency Capture"));
+    Serial.println(F("  [b] Enter Binary Host Control"));
+    Serial.println(F("  [c] Toggle Closed-Loop Wheel Control"));
+    Serial.println(F("  [f] Dump Flight Recorder"));
+    Serial.println(F("  [u] Print USB Service Metrics"));
     Serial.println(F("==================================="));
 }
 
+void printDriveTuning() {
+    Serial.print(F("Ramp factor: "));
+    Serial.print(mecanumDrive.getRampFactor(), 2);
+    Serial.print(F("\tStrafing scale: "));
+    Serial.print(mecanumDrive.getStrafingScale(), 2);
+    Serial.print(F("\tLookup table: "));
+    if (!mecanumDrive.isLookupTableEnabled()) {
+        Serial.println(F("off"));
+    } else if (mecanumDrive.isLookupTableReady()) {
+        Serial.println(F("on"));
+    } else {
+        Serial.println(F("rebuilding"));
+    }
+}
+
+// Collect a tuning value and apply it once the line is complete
+void handleTuningInput(char c) {
+    if (c != '\n' && c != '\r') {
+        if (tuningInputLength < sizeof(tuningInput) - 1) {
+            tuningInput[tuningInputLength++] = c;
+        }
+        return;
+    }
+
+    // Line ending sent right after the command letter
+    if (tuningInputLength == 0) {
+        return;
+    }
+
+    tuningInput[tuningInputLength] = '\0';
+    char command = pendingTuningCommand;
+    pendingTuningCommand = '\0';
+    tuningInputLength = 0;
+
+    // Reject empty or trailing garbage instead of storing 0
+    char *end;
+    float value = strtod(tuningInput, &end);
+    while (*end == ' ') end++;
+    if (end == tuningInput || *end != '\0') {
+        Serial.println(F("Invalid value."));
+        return;
+    }
+
+    bool accepted = command == 'r' ? mecanumDrive.setRampFactor(value)
+                                   : mecanumDrive.setStrafingScale(value);
+    if (accepted) {
+        Serial.println(F("Tuning applied, saving to EEPROM in the background."));
+        printDriveTuning();
+    } else {
+        Serial.println(F("Value out of range."));
+    }
+}
+
+// Record deadman transitions in the flight recorder
+void recordDeadman(bool held) {
+    static bool lastHeld = false;
+    if (held != lastHeld) {
+        flightRecorder.record(FLIGHT_DEADMAN, held);
+        lastHeld = held;
+    }
+}
+
+// Apply the latest host setpoint through the same drive path as the Xbox controller
+void applyHostSetpoint() {
+    if (setpointLink.getSetpointType() == SetpointLink::FRAME_WHEELS) {
+        mecanumDrive.setWheelPowers(setpointLink.getSetpoint(0), setpointLink.getSetpoint(1),
+                                    setpointLink.getSetpoint(2), setpointLink.getSetpoint(3));
+    } else {
+        // Host setpoints are analog, so skip the stick snapping in move()
+        mecanumDrive.moveAnalog(setpointLink.getSetpoint(0), setpointLink.getSetpoint(1),
+                                setpointLink.getSetpoint(2));
+    }
+}
+
+// Service the binary setpoint channel, called every loop while host control is active
+void serviceHostControl() {
+    unsigned long now = millis();
+
+    while (Serial.available()) {
+        if (!setpointLink.feed(Serial.read(), now)) {
+            continue;
+        }
+
+        uint8_t type = setpointLink.getFrameType();
+        if (type == SetpointLink::FRAME_STATUS_REQUEST) {
+            uint8_t flags = (deadManActivated() ? 0x01 : 0) | (mecanumDrive.areMotorsEnabled() ? 0x02 : 0);
+            uint8_t frame[SetpointLink::MAX_FRAME];
+            Serial.write(frame, setpointLink.encodeStatus(frame, flags));
+        } else if (type == SetpointLink::FRAME_EXIT) {
+            mecanumDrive.disableMotors();
+            hostControlActive = false;
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_MENU);
+            Serial.println(F("Exited binary host control."));
+            return;
+        }
+    }
+
+    // Motion needs a fresh setpoint and the deadman, exactly like the Xbox path
+    bool deadman = xbox.isConnected() && deadManActivated();
+    recordDeadman(deadman);
+    if (deadman && setpointLink.hasFreshSetpoint(now)) {
+        // Only write the DAC when something changed, so the loop keeps up with the frame rate
+        bool newSetpoint = setpointLink.takeNewSetpoint();
+        if (!mecanumDrive.areMotorsEnabled()) {
+            mecanumDrive.enableMotors();
+            applyHostSetpoint();
+        } else if (newSetpoint) {
+            applyHostSetpoint();
+        }
+        hmi.setGreen(true);
+    } else {
+        if (mecanumDrive.areMotorsEnabled()) {
+            mecanumDrive.disableMotors();
+        }
+        hmi.blinkGreen();
+    }
+}
+
+// Restart the overrun check after a deliberate blocking wait, so it is not
+// recorded as a stalled control loop
+void restartLoopTimer() {
+    lastLoopStart = millis();
+}
+
 void loop() {
-    Usb.Task();
+    // Record loops that took too long
+    unsigned long loopStart = millis();
+    if (loopStart - lastLoopStart > loopOverrunMs) {
+        flightRecorder.record(FLIGHT_LOOP_OVERRUN, 0, loopStart - lastLoopStart);
+    }
+    lastLoopStart = loopStart;
+
+    // Hand new controller reports to XboxController, timestamping them for latency capture
+    if (usbService.service() && xbox.inputChanged()) {
+        xbox.notifyReportReady();
+        latencyProbe.mark(LatencyProbe::STAGE_INPUT);
+    }
+
     static bool setupComplete = false;
     static bool menuDisplayed = false;
     static bool motorFaultRecovered = false;
@@ -97,6 +276,7 @@ void loop() {
     if (hmi.motorInFault()) {
       if (!motorFaultRecovered) {
             Serial.println(F("Motor fault detected!"));
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_FAULT);
             mecanumDrive.disableMotors();
             motorFaultRecovered = true;
         }
@@ -107,6 +287,7 @@ void loop() {
     // Recover from motor fault
     if (motorFaultRecovered) {
         Serial.println(F("Motor fault cleared. Press the Xbox button to continue."));
+        flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_FAULT_CLEARED);
         motorFaultRecovered = false;
         setupComplete = false;
     }
@@ -114,14 +295,17 @@ void loop() {
     // Wait for Xbox button press if setup is not complete
     if (!setupComplete) {
         Serial.println(F("Waiting for Xbox button press..."));
+        flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_WAIT_BUTTON);
         xbox.setLedRotating();
         if (waitForXboxButton()) {
             if (!mecanumDrive.initialize()) {
                 Serial.println(F("Failed to initialize MecanumControl!"));
+                flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_INIT_FAILED);
                 while (1);
             }
 
             Serial.println(F("Setup complete"));
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_RUNNING);
             setupComplete = true;
             xbox.setLedToLED1();
             hmi.blinkGreen();
@@ -129,25 +313,88 @@ void loop() {
             delay(100);
             xbox.stopRumble();
         }
+        restartLoopTimer();
         return;
     } 
 
+    // Wheel velocity loop every 10 ms, a no-op while running open loop
+    mecanumDrive.serviceVelocityLoop();
+
+    // Host computer in charge, no menu prints on the serial line
+    if (hostControlActive) {
+        serviceHostControl();
+        hmi.update();
+        return;
+    }
+
     // Display the main menu if not already displayed
     if (!menuDisplayed) {
         printMainMenu();
         menuDisplayed = true;
     }
 
+    // Rebuild the lookup table and save tuning in the background, one step per loop
+    mecanumDrive.serviceLookupTable();
+
     // Handle serial input commands
-    if (Serial.available()) {
+    if (Serial.available() && pendingTuningCommand != '\0') {
+        handleTuningInput(Serial.read());
+    } else if (Serial.available()) {
         char command = Serial.read();
         menuDisplayed = false;
 
         if (command == 'd') {
-            enterDebugMode(mecanumDrive, xbox);
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_DEBUG);
+            enterDebugMode(mecanumDrive, xbox, latencyProbe);
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_MENU);
+            restartLoopTimer();
         } else if (command == 'h') {
             printMainMenu();
             menuDisplayed = true;
+        } else if (command == 't') {
+            mecanumDrive.setLookupTableEnabled(!mecanumDrive.isLookupTableEnabled());
+            printDriveTuning();
+            menuDisplayed = true;
+        } else if (command == 'r' || command == 'k') {
+            Serial.println(command == 'r' ? F("Enter ramp factor:") : F("Enter strafing scale:"));
+            pendingTuningCommand = command;
+            menuDisplayed = true;
+        } else if (command == 'c') {
+            mecanumDrive.setClosedLoopEnabled(!mecanumDrive.isClosedLoopEnabled());
+            Serial.println(mecanumDrive.isClosedLoopEnabled() ? F("Closed-loop wheel control on.")
+                                                              : F("Closed-loop wheel control off."));
+            menuDisplayed = true;
+        } else if (command == 'u') {
+            Serial.print(F("Loops/s: "));
+            Serial.print(usbService.getLoopsPerSecond());
+            Serial.print(F("\tUsb.Task() calls/s (SPI poll proxy): "));
+            Serial.print(usbService.getTasksPerSecond());
+            Serial.print(F("\tAvg Usb.Task(): "));
+            Serial.print(usbService.getAverageTaskUs());
+            Serial.print(F(" us\tSaved per loop: ~"));
+            Serial.print(usbService.getSavedUsPerLoop());
+            Serial.println(F(" us"));
+            menuDisplayed = true;
+        } else if (command == 'f') {
+            flightRecorder.dump(Serial);
+            restartLoopTimer();
+            menuDisplayed = true;
+        } else if (command == 'b') {
+            Serial.println(F("Entering binary host control. Send an exit frame to return."));
+            Serial.flush();
+            setpointLink.reset();
+            hostControlActive = true;
+            flightRecorder.record(FLIGHT_STATE, FLIGHT_STATE_HOST_CONTROL);
+        } else if (command == 'l') {
+            if (latencyProbe.isArmed()) {
+                latencyProbe.disarm();
+                printLatencyReport(latencyProbe);
+            } else {
+                latencyProbe.reset();
+                latencyProbe.arm();
+                Serial.println(F("Live latency capture started. Hold the deadman and move the sticks, then press [l] again."));
+            }
+            menuDisplayed = true;
         } else {
             Serial.println(F("Invalid command. Type 'h' for help."));
         }
@@ -156,7 +403,9 @@ void loop() {
     // Handle Xbox controller input and motor control
     float x, y, turn;
     // print status of deadManActivated
-    if (xbox.isConnected() && deadManActivated()) {
+    bool deadman = xbox.isConnected() && deadManActivated();
+    recordDeadman(deadman);
+    if (deadman) {
         xbox.update();
 
         x = xbox.getX();
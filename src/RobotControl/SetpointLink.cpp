@@ -0,0 +1,226 @@
+#include "SetpointLink.h"
+
+// Constructor
+SetpointLink::SetpointLink() {
+  reset();
+}
+
+// Clear parser state, setpoint and statistics
+void SetpointLink::reset() {
+  state = WAIT_SYNC_1;
+  haveSeq = false;
+  lastSeq = 0;
+  lastType = 0;
+  txSeq = 0;
+
+  setpointType = FRAME_MOTION;
+  for (uint8_t i = 0; i < 4; i++) {
+    setpoint[i] = 0;
+  }
+  setpointFresh = false;
+  setpointNew = false;
+  setpointTime = 0;
+
+  framesOk = 0;
+  crcErrors = 0;
+  framingErrors = 0;
+  droppedFrames = 0;
+  timeouts = 0;
+  staleFrames = 0;
+}
+
+// CRC-16/CCITT-FALSE update
+uint16_t SetpointLink::crcUpdate(uint16_t crc, uint8_t byte) {
+  crc ^= (uint16_t)byte << 8;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Expected payload length of a frame type, or -1 if the type is unknown
+static int payloadLength(uint8_t type) {
+  switch (type) {
+    case SetpointLink::FRAME_MOTION: return 6;
+    case SetpointLink::FRAME_WHEELS: return 8;
+    case SetpointLink::FRAME_STATUS_REQUEST: return 0;
+    case SetpointLink::FRAME_EXIT: return 0;
+    default: return -1;
+  }
+}
+
+// Feed one received byte, returns true when a valid frame completed
+bool SetpointLink::feed(uint8_t byte, unsigned long nowMs) {
+  switch (state) {
+    case WAIT_SYNC_1:
+      if (byte == SYNC_1) state = WAIT_SYNC_2;
+      return false;
+
+    case WAIT_SYNC_2:
+      state = byte == SYNC_2 ? READ_SEQ : (byte == SYNC_1 ? WAIT_SYNC_2 : WAIT_SYNC_1);
+      return false;
+
+    case READ_SEQ:
+      seq = byte;
+      crc = crcUpdate(0xFFFF, byte);
+      state = READ_TYPE;
+      return false;
+
+    case READ_TYPE:
+      type = byte;
+      crc = crcUpdate(crc, byte);
+      state = READ_LEN;
+      return false;
+
+    case READ_LEN:
+      if (byte > MAX_PAYLOAD) {
+        framingErrors++;
+        state = WAIT_SYNC_1;
+        return false;
+      }
+      length = byte;
+      received = 0;
+      crc = crcUpdate(crc, byte);
+      state = length ? READ_PAYLOAD : READ_CRC_HIGH;
+      return false;
+
+    case READ_PAYLOAD:
+      payload[received++] = byte;
+      crc = crcUpdate(crc, byte);
+      if (received == length) state = READ_CRC_HIGH;
+      return false;
+
+    case READ_CRC_HIGH:
+      frameCrc = (uint16_t)byte << 8;
+      state = READ_CRC_LOW;
+      return false;
+
+    case READ_CRC_LOW:
+      frameCrc |= byte;
+      state = WAIT_SYNC_1;
+      if (frameCrc != crc) {
+        crcErrors++;
+        return false;
+      }
+      return acceptFrame(nowMs);
+  }
+  return false;
+}
+
+// Validate a frame that passed the CRC and latch its contents
+bool SetpointLink::acceptFrame(unsigned long nowMs) {
+  if (payloadLength(type) != length) {
+    framingErrors++;
+    return false;
+  }
+
+  // Exit and status requests carry no setpoint, so they are always honoured:
+  // a restarted host must be able to stop the session whatever its sequence
+  if (type == FRAME_EXIT || type == FRAME_STATUS_REQUEST) {
+    lastType = type;
+    framesOk++;
+    return true;
+  }
+
+  // Every setpoint frame carries the next sequence number, so a replayed or
+  // reordered frame must not override a newer setpoint
+  if (haveSeq) {
+    uint8_t ahead = seq - lastSeq;
+    if (ahead == 0 || ahead >= SEQ_WINDOW) {
+      staleFrames++;
+      return false;
+    }
+    droppedFrames += ahead - 1;
+  }
+  haveSeq = true;
+  lastSeq = seq;
+  lastType = type;
+  framesOk++;
+
+  uint8_t count = length / 2;
+  for (uint8_t i = 0; i < count; i++) {
+    setpoint[i] = (int16_t)(payload[2 * i] | (uint16_t)payload[2 * i + 1] << 8);
+  }
+  setpointType = type;
+  setpointFresh = true;
+  setpointNew = true;
+  setpointTime = nowMs;
+  return true;
+}
+
+// Type of the last valid frame
+uint8_t SetpointLink::getFrameType() const {
+  return lastType;
+}
+
+// Check if a setpoint arrived within SETPOINT_TIMEOUT_MS
+bool SetpointLink::hasFreshSetpoint(unsigned long nowMs) {
+  if (setpointFresh && nowMs - setpointTime > SETPOINT_TIMEOUT_MS) {
+    setpointFresh = false;
+    timeouts++;
+
+    // The stream stopped, a host that reconnects may start from any sequence
+    haveSeq = false;
+  }
+  return setpointFresh;
+}
+
+// Returns true once per newly received setpoint
+bool SetpointLink::takeNewSetpoint() {
+  bool isNew = setpointNew;
+  setpointNew = false;
+  return isNew;
+}
+
+// Type of the latest setpoint (FRAME_MOTION or FRAME_WHEELS)
+uint8_t SetpointLink::getSetpointType() const {
+  return setpointType;
+}
+
+// Latest setpoint value normalized to [-1, 1]
+float SetpointLink::getSetpoint(uint8_t index) const {
+  int16_t value = setpoint[index];
+  if (value < -32767) value = -32767;
+  return value / 32767.0;
+}
+
+// Append a little-endian value to a frame
+static uint8_t putLE(uint8_t *out, uint32_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; i++) {
+    out[i] = (value >> (8 * i)) & 0xFF;
+  }
+  return bytes;
+}
+
+// Encode a FRAME_STATUS frame, returns its length
+uint8_t SetpointLink::encodeStatus(uint8_t frame[MAX_FRAME], uint8_t flags) {
+  uint8_t n = 0;
+  frame[n++] = SYNC_1;
+  frame[n++] = SYNC_2;
+  frame[n++] = txSeq++;
+  frame[n++] = FRAME_STATUS;
+  frame[n++] = STATUS_PAYLOAD;
+  n += putLE(frame + n, framesOk, 4);
+  n += putLE(frame + n, crcErrors, 2);
+  n += putLE(frame + n, framingErrors, 2);
+  n += putLE(frame + n, droppedFrames, 2);
+  n += putLE(frame + n, timeouts, 2);
+  n += putLE(frame + n, staleFrames, 2);
+  frame[n++] = lastSeq;
+  frame[n++] = flags;
+
+  uint16_t frameCrc = 0xFFFF;
+  for (uint8_t i = 2; i < n; i++) {
+    frameCrc = crcUpdate(frameCrc, frame[i]);
+  }
+  frame[n++] = frameCrc >> 8;
+  frame[n++] = frameCrc & 0xFF;
+  return n;
+}
+
+uint32_t SetpointLink::getFramesOk() const { return framesOk; }
+uint16_t SetpointLink::getCrcErrors() const { return crcErrors; }
+uint16_t SetpointLink::getFramingErrors() const { return framingErrors; }
+uint16_t SetpointLink::getDroppedFrames() const { return droppedFrames; }
+uint16_t SetpointLink::getTimeouts() const { return timeouts; }
+uint16_t SetpointLink::getStaleFrames() const { return staleFrames; }
@@ -0,0 +1,114 @@
+#ifndef SETPOINTLINK_H
+#define SETPOINTLINK_H
+
+#include <stdint.h>
+
+// Framed binary setpoint channel for host-computer control over serial.
+//
+// Frame layout (multi-byte fields little-endian):
+//   0xA5 0x5A | seq | type | len | payload[len] | crc16
+// The CRC is CRC-16/CCITT-FALSE over seq, type, len and the payload, sent
+// high byte first. Setpoints are signed Q15 values (-32767 = -1, 32767 = 1).
+//
+// The parser has no Arduino dependency so it also runs in a host build.
+class SetpointLink {
+public:
+  static const uint8_t SYNC_1 = 0xA5;
+  static const uint8_t SYNC_2 = 0x5A;
+  static const uint8_t MAX_PAYLOAD = 8;
+  static const uint8_t STATUS_PAYLOAD = 16;
+  static const uint8_t MAX_FRAME = 5 + STATUS_PAYLOAD + 2;
+
+  // Setpoints older than this stop the base
+  static const unsigned long SETPOINT_TIMEOUT_MS = 100;
+
+  // A setpoint frame is accepted only if its sequence number is 1 to
+  // SEQ_WINDOW - 1 ahead of the last accepted one (mod 256); anything else is
+  // a duplicate or arrived out of order and is counted as stale. Exit and
+  // status requests skip the check, and a setpoint timeout forgets the last
+  // sequence so a restarted host can start over from any number.
+  static const uint8_t SEQ_WINDOW = 128;
+
+  enum FrameType {
+    FRAME_MOTION = 0x01,         // int16 x, y, turn
+    FRAME_WHEELS = 0x02,         // int16 frontLeft, frontRight, rearLeft, rearRight
+    FRAME_STATUS_REQUEST = 0x10, // No payload, answered with FRAME_STATUS
+    FRAME_EXIT = 0x7F,           // No payload, leave host control
+    FRAME_STATUS = 0x90          // Sent to the host, see encodeStatus()
+  };
+
+  SetpointLink();
+
+  // Clear parser state, setpoint and statistics
+  void reset();
+
+  // Feed one received byte, returns true when a valid frame completed
+  bool feed(uint8_t byte, unsigned long nowMs);
+
+  // Type of the last valid frame
+  uint8_t getFrameType() const;
+
+  // Check if a setpoint arrived within SETPOINT_TIMEOUT_MS
+  // Counts a timeout each time a fresh setpoint goes stale
+  bool hasFreshSetpoint(unsigned long nowMs);
+
+  // Returns true once per newly received setpoint
+  bool takeNewSetpoint();
+
+  // Type of the latest setpoint (FRAME_MOTION or FRAME_WHEELS)
+  uint8_t getSetpointType() const;
+
+  // Latest setpoint value normalized to [-1, 1]
+  // FRAME_MOTION uses indices 0-2 (x, y, turn), FRAME_WHEELS uses 0-3
+  float getSetpoint(uint8_t index) const;
+
+  // Encode a FRAME_STATUS frame, returns its length
+  // Payload: uint32 framesOk, uint16 crcErrors, uint16 framingErrors,
+  //          uint16 droppedFrames, uint16 timeouts, uint16 staleFrames,
+  //          uint8 lastSeq, uint8 flags
+  uint8_t encodeStatus(uint8_t frame[MAX_FRAME], uint8_t flags);
+
+  uint32_t getFramesOk() const;
+  uint16_t getCrcErrors() const;
+  uint16_t getFramingErrors() const;
+  uint16_t getDroppedFrames() const;
+  uint16_t getTimeouts() const;
+  uint16_t getStaleFrames() const;
+
+  // CRC-16/CCITT-FALSE update
+  static uint16_t crcUpdate(uint16_t crc, uint8_t byte);
+
+private:
+  enum ParserState { WAIT_SYNC_1, WAIT_SYNC_2, READ_SEQ, READ_TYPE, READ_LEN, READ_PAYLOAD, READ_CRC_HIGH, READ_CRC_LOW };
+
+  bool acceptFrame(unsigned long nowMs);
+
+  ParserState state;
+  uint8_t seq;
+  uint8_t type;
+  uint8_t length;
+  uint8_t received;
+  uint8_t payload[MAX_PAYLOAD];
+  uint16_t crc;
+  uint16_t frameCrc;
+
+  bool haveSeq;
+  uint8_t lastSeq;
+  uint8_t lastType;
+  uint8_t txSeq;
+
+  uint8_t setpointType;
+  int16_t setpoint[4];
+  bool setpointFresh;
+  bool setpointNew;
+  unsigned long setpointTime;
+
+  uint32_t framesOk;
+  uint16_t crcErrors;
+  uint16_t framingErrors;
+  uint16_t droppedFrames;
+  uint16_t timeouts;
+  uint16_t staleFrames;
+};
+
+#endif // SETPOINTLINK_H
@@ -0,0 +1,72 @@
+#include "UsbService.h"
+
+// Constructor
+UsbService::UsbService(USB &usb, uint8_t intPin, unsigned long minPollIntervalUs)
+    : usb(usb), intPin(intPin), minPollIntervalUs(minPollIntervalUs), lastTaskTime(0),
+      windowStart(0), loops(0), tasks(0), taskUs(0),
+      loopsPerSecond(0), tasksPerSecond(0), averageTaskUs(0) {}
+
+// Restrict INT to bus events (call after Usb.Init())
+void UsbService::begin() {
+  pinMode(intPin, INPUT);
+
+  // Usb.Init() also enables the 1 ms frame interrupt, which the library never
+  // acknowledges, so INT would stay asserted. Frame timing is still read from
+  // HIRQ directly during enumeration.
+  usb.regWr(rHIEN, bmCONDETIE);
+
+  lastTaskTime = micros();
+  windowStart = lastTaskTime;
+}
+
+// Run Usb.Task() if it is due, returns true if it ran
+bool UsbService::service() {
+  unsigned long now = micros();
+  loops++;
+
+  // INT is active low
+  bool due = digitalRead(intPin) == LOW || now - lastTaskTime >= minPollIntervalUs;
+  if (!due) {
+    updateWindow(now);
+    return false;
+  }
+
+  usb.Task();
+
+  unsigned long end = micros();
+  tasks++;
+  taskUs += end - now;
+  lastTaskTime = now;
+  updateWindow(end);
+  return true;
+}
+
+// Latch the metrics once a second
+void UsbService::updateWindow(unsigned long now) {
+  unsigned long elapsed = now - windowStart;
+  if (elapsed < 1000000) {
+    return;
+  }
+
+  loopsPerSecond = loops * 1000000.0 / elapsed;
+  tasksPerSecond = tasks * 1000000.0 / elapsed;
+  averageTaskUs = tasks ? taskUs / tasks : 0;
+
+  windowStart = now;
+  loops = 0;
+  tasks = 0;
+  taskUs = 0;
+}
+
+unsigned long UsbService::getLoopsPerSecond() const { return loopsPerSecond; }
+unsigned long UsbService::getTasksPerSecond() const { return tasksPerSecond; }
+unsigned long UsbService::getAverageTaskUs() const { return averageTaskUs; }
+
+// Estimated time saved per loop compared to calling Usb.Task() every loop
+unsigned long UsbService::getSavedUsPerLoop() const {
+  if (loopsPerSecond == 0) {
+    return 0;
+  }
+  unsigned long skipped = loopsPerSecond > tasksPerSecond ? loopsPerSecond - tasksPerSecond : 0;
+  return skipped * averageTaskUs / loopsPerSecond;
+}
@@ -0,0 +1,55 @@
+#ifndef USBSERVICE_H
+#define USBSERVICE_H
+
+#include <Arduino.h>
+#include <Usb.h>
+
+// Gates Usb.Task() on the MAX3421E interrupt line.
+//
+// Every Usb.Task() call talks to the MAX3421E over SPI, and the XBOXUSB
+// driver issues an IN transfer on each call even when no report is pending.
+// USB is host-polled, so the MAX3421E cannot announce a pending report by
+// itself. Instead, the task runs when INT is asserted (connect/disconnect)
+// or when the minimum poll interval has elapsed, and every other loop skips
+// the SPI traffic.
+class UsbService {
+public:
+  UsbService(USB &usb, uint8_t intPin, unsigned long minPollIntervalUs);
+
+  // Restrict INT to bus events (call after Usb.Init())
+  void begin();
+
+  // Run Usb.Task() if it is due, returns true if it ran
+  bool service();
+
+  // Metrics over the last complete one-second window
+  // Usb.Task() calls stand in for SPI polling; the transfers inside each
+  // call are not counted
+  unsigned long getLoopsPerSecond() const;
+  unsigned long getTasksPerSecond() const;
+  unsigned long getAverageTaskUs() const;
+
+  // Estimated time saved per loop compared to calling Usb.Task() every loop
+  unsigned long getSavedUsPerLoop() const;
+
+private:
+  void updateWindow(unsigned long now);
+
+  USB &usb;
+  uint8_t intPin;
+  unsigned long minPollIntervalUs;
+  unsigned long lastTaskTime;
+
+  // Current window
+  unsigned long windowStart;
+  unsigned long loops;
+  unsigned long tasks;
+  unsigned long taskUs;
+
+  // Last complete window
+  unsigned long loopsPerSecond;
+  unsigned long tasksPerSecond;
+  unsigned long averageTaskUs;
+};
+
+#endif // USBSERVICE_H
@@ -0,0 +1,106 @@
+#include "WheelVelocityController.h"
+
+// Constructor
+WheelVelocityController::WheelVelocityController(unsigned long periodUs, int16_t fullScaleCounts, int16_t kp, int16_t ki)
+    : periodUs(periodUs), fullScaleCounts(fullScaleCounts) {
+  setGains(kp, ki);
+  reset();
+  resetTelemetry();
+}
+
+// Clear integrators and targets
+void WheelVelocityController::reset() {
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    feedForward[wheel] = 0;
+    target[wheel] = 0;
+    measured[wheel] = 0;
+    error[wheel] = 0;
+    integral[wheel] = 0;
+  }
+}
+
+// Set the encoder counts per tick expected at full DAC output
+void WheelVelocityController::setFullScaleCounts(int16_t fullScaleCounts) {
+  this->fullScaleCounts = fullScaleCounts;
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    setFeedForward(wheel, feedForward[wheel]);
+  }
+}
+
+// Set the gains (Q8 DAC codes per count per tick)
+void WheelVelocityController::setGains(int16_t kp, int16_t ki) {
+  this->kp = kp;
+  this->ki = ki;
+
+  // ki * integral >> 12 may not exceed INTEGRAL_LIMIT_CODES
+  integralLimit = ki > 0 ? ((int32_t)INTEGRAL_LIMIT_CODES << 12) / ki : 0;
+}
+
+int16_t WheelVelocityController::getKp() const { return kp; }
+int16_t WheelVelocityController::getKi() const { return ki; }
+
+// Set the open-loop DAC code of a wheel, in [-4095, 4095]
+void WheelVelocityController::setFeedForward(uint8_t wheel, int16_t dacCode) {
+  feedForward[wheel] = dacCode;
+  target[wheel] = (int32_t)dacCode * fullScaleCounts * 16 / MAX_CODE;
+}
+
+int16_t WheelVelocityController::getFeedForward(uint8_t wheel) const { return feedForward[wheel]; }
+
+// Run one control tick for a wheel from the counts seen over elapsedUs
+int16_t WheelVelocityController::update(uint8_t wheel, int16_t measuredCounts, unsigned long elapsedUs) {
+  if (elapsedUs == 0) {
+    elapsedUs = periodUs;
+  }
+
+  // Counts per nominal tick, whatever time they actually cover
+  measured[wheel] = (int32_t)measuredCounts * 16 * (int32_t)periodUs / (int32_t)elapsedUs;
+  int16_t tickError = target[wheel] - measured[wheel];
+  error[wheel] = tickError;
+
+  // Q8 gains on Q4 velocities, so shift out 12 bits
+  int32_t correction = ((int32_t)kp * tickError + (int32_t)ki * integral[wheel]) >> 12;
+  int32_t output = feedForward[wheel] + correction;
+
+  // Anti-windup: stop integrating while the output is saturated in the
+  // direction the error pushes
+  bool saturatedHigh = output >= MAX_CODE && tickError > 0;
+  bool saturatedLow = output <= -MAX_CODE && tickError < 0;
+  if (!saturatedHigh && !saturatedLow) {
+    // The integral grows with the time the error was held, not the tick count
+    integral[wheel] += (int32_t)tickError * (int32_t)elapsedUs / (int32_t)periodUs;
+    if (integral[wheel] > integralLimit) integral[wheel] = integralLimit;
+    if (integral[wheel] < -integralLimit) integral[wheel] = -integralLimit;
+  }
+
+  if (output > MAX_CODE) output = MAX_CODE;
+  if (output < -MAX_CODE) output = -MAX_CODE;
+
+  // Telemetry
+  int16_t absError = tickError < 0 ? -tickError : tickError;
+  if (absError > maxAbsError[wheel]) maxAbsError[wheel] = absError;
+  if (telemetryTicks[wheel] < 0xFFFF) {
+    absErrorSum[wheel] += absError;
+    telemetryTicks[wheel]++;
+  }
+
+  return output;
+}
+
+// Tracking telemetry, velocities in Q4 counts per tick
+int16_t WheelVelocityController::getTarget(uint8_t wheel) const { return target[wheel]; }
+int16_t WheelVelocityController::getMeasured(uint8_t wheel) const { return measured[wheel]; }
+int16_t WheelVelocityController::getError(uint8_t wheel) const { return error[wheel]; }
+int16_t WheelVelocityController::getMaxAbsError(uint8_t wheel) const { return maxAbsError[wheel]; }
+
+int16_t WheelVelocityController::getMeanAbsError(uint8_t wheel) const {
+  return telemetryTicks[wheel] ? absErrorSum[wheel] / telemetryTicks[wheel] : 0;
+}
+
+void WheelVelocityController::resetTelemetry() {
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    maxAbsError[wheel] = 0;
+    absErrorSum[wheel] = 0;
+    telemetryTicks[wheel] = 0;
+  }
+}
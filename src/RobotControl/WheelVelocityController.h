@@ -0,0 +1,71 @@
+#ifndef WHEELVELOCITYCONTROLLER_H
+#define WHEELVELOCITYCONTROLLER_H
+
+#include <stdint.h>
+
+// Integer PI velocity loop for the four wheels.
+//
+// The open-loop DAC code of each wheel is both the feed-forward term and,
+// through the same linear power-to-DAC map, the velocity target: a code of
+// 4095 should turn the wheel at fullScaleCounts encoder counts per tick.
+// Velocities are kept in Q4 counts per tick, gains in Q8 DAC codes per count
+// per tick of error. The caller runs the loop from the main loop, so each
+// update() is given the time the counts actually cover and rescales them to
+// the nominal tick.
+//
+// No Arduino dependency, so the loop can be run against a simulated motor in
+// a host build.
+class WheelVelocityController {
+public:
+  static const uint8_t WHEELS = 4;
+  static const int16_t MAX_CODE = 4095;
+  static const int16_t INTEGRAL_LIMIT_CODES = 1024; // Most the integral term may add
+
+  WheelVelocityController(unsigned long periodUs, int16_t fullScaleCounts, int16_t kp, int16_t ki);
+
+  // Clear integrators and targets
+  void reset();
+
+  // Set the open-loop DAC code of a wheel, in [-4095, 4095]
+  void setFeedForward(uint8_t wheel, int16_t dacCode);
+  int16_t getFeedForward(uint8_t wheel) const;
+
+  // Run one control tick for a wheel from the counts seen over elapsedUs,
+  // returns the DAC code to output
+  int16_t update(uint8_t wheel, int16_t measuredCounts, unsigned long elapsedUs);
+
+  // Set the encoder counts per tick expected at full DAC output
+  void setFullScaleCounts(int16_t fullScaleCounts);
+
+  // Set the gains (Q8 DAC codes per count per tick)
+  void setGains(int16_t kp, int16_t ki);
+  int16_t getKp() const;
+  int16_t getKi() const;
+
+  // Tracking telemetry, velocities in Q4 counts per tick
+  int16_t getTarget(uint8_t wheel) const;
+  int16_t getMeasured(uint8_t wheel) const;
+  int16_t getError(uint8_t wheel) const;
+  int16_t getMaxAbsError(uint8_t wheel) const;
+  int16_t getMeanAbsError(uint8_t wheel) const;
+  void resetTelemetry();
+
+private:
+  unsigned long periodUs; // Nominal tick the velocities are expressed in
+  int16_t fullScaleCounts;
+  int16_t kp;
+  int16_t ki;
+  int32_t integralLimit; // Integrator clamp in Q4 counts, derived from ki
+
+  int16_t feedForward[WHEELS];
+  int16_t target[WHEELS];
+  int16_t measured[WHEELS];
+  int16_t error[WHEELS];
+  int32_t integral[WHEELS];
+
+  int16_t maxAbsError[WHEELS];
+  uint32_t absErrorSum[WHEELS];
+  uint16_t telemetryTicks[WHEELS];
+};
+
+#endif // WHEELVELOCITYCONTROLLER_H
@@ -2,6 +2,7 @@
 #define XBOXCONTROLLER_H
 
 #include <XBOXUSB.h>
+#include "LatencyProbe.h"
 
 // Constants
 const float LEFT_DEADZONE = 0.1;  // Deadzone for the left joystick (-1 to 1)
@@ -13,13 +14,16 @@ public:
   XboxController(USB* usb) : Xbox(usb) {}
 
   // Update the controller state
+  // Only re-normalizes the axes after notifyReportReady() or with scripted input
   void update() {
     if (disabled) return;
+    if (!reportReady && !scripted) return;
+    reportReady = false;
 
     // Read joystick inputs (values from -32768 to 32767)
-    int16_t xRaw = Xbox.getAnalogHat(LeftHatX);
-    int16_t yRaw = Xbox.getAnalogHat(LeftHatY);
-    int16_t turnRaw = Xbox.getAnalogHat(RightHatX);
+    int16_t xRaw = scripted ? scriptedX : Xbox.getAnalogHat(LeftHatX);
+    int16_t yRaw = scripted ? scriptedY : Xbox.getAnalogHat(LeftHatY);
+    int16_t turnRaw = scripted ? scriptedTurn : Xbox.getAnalogHat(RightHatX);
 
     // Normalize inputs to range -1 to 1
     xNorm = xRaw / 32767.0;
@@ -32,6 +36,46 @@ public:
 
     // Apply deadzone for the right joystick
     if (abs(turnNorm) < RIGHT_DEADZONE) turnNorm = 0;
+
+    if (latencyProbe) latencyProbe->mark(LatencyProbe::STAGE_UPDATE);
+  }
+
+  // Check if the joystick axes changed since the last call
+  bool inputChanged() {
+    int16_t xRaw = Xbox.getAnalogHat(LeftHatX);
+    int16_t yRaw = Xbox.getAnalogHat(LeftHatY);
+    int16_t turnRaw = Xbox.getAnalogHat(RightHatX);
+
+    bool changed = xRaw != lastXRaw || yRaw != lastYRaw || turnRaw != lastTurnRaw;
+    lastXRaw = xRaw;
+    lastYRaw = yRaw;
+    lastTurnRaw = turnRaw;
+    return changed;
+  }
+
+  // Flag that a new report changed the axes (call after Usb.Task())
+  void notifyReportReady() {
+    reportReady = true;
+  }
+
+  // Replace the joystick axes with scripted raw values in update()
+  void setScriptedInput(int16_t xRaw, int16_t yRaw, int16_t turnRaw) {
+    scripted = true;
+    scriptedX = xRaw;
+    scriptedY = yRaw;
+    scriptedTurn = turnRaw;
+  }
+
+  // Return to reading the joystick axes from the controller
+  void clearScriptedInput() {
+    scripted = false;
+    // The axes still hold the last scripted values, re-read the controller
+    reportReady = true;
+  }
+
+  // Attach a probe to timestamp update() (nullptr to detach)
+  void setLatencyProbe(LatencyProbe *probe) {
+    latencyProbe = probe;
   }
 
   // Check if the Xbox controller is connected
@@ -67,6 +111,8 @@ public:
   // Enable or disable the controller
   void setDisabled(bool state) {
     disabled = state;
+    // Reports that arrived while disabled were skipped, re-read the axes
+    if (!state) reportReady = true;
   }
 
   // Shim to set rumble on
@@ -117,6 +163,22 @@ private:
   float yNorm = 0;
   float turnNorm = 0;
   bool disabled = false;
+
+  // Set when a new report is waiting for update()
+  bool reportReady = false;
+
+  // Last raw axes seen by inputChanged()
+  int16_t lastXRaw = 0;
+  int16_t lastYRaw = 0;
+  int16_t lastTurnRaw = 0;
+
+  // Scripted raw axes used instead of the controller
+  bool scripted = false;
+  int16_t scriptedX = 0;
+  int16_t scriptedY = 0;
+  int16_t scriptedTurn = 0;
+
+  LatencyProbe *latencyProbe = nullptr;
 };
 
 #endif // XBOXCONTROLLER_H
\ No newline at end of file
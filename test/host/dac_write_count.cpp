@@ -0,0 +1,96 @@
+// Runs the scripted latency characterization on the host and checks how many
+// MCP4728 channel writes each stick step costs, for both the direct path and
+// the lookup table. The run goes through the debug menu with the velocity
+// loop on, as on the robot.
+//
+// The fake clock only advances inside the DAC stand-in, so the printed report
+// is a count of I2C writes expressed in microseconds, not a latency figure:
+// update() and move() always read 0. Real stage latencies come from [l] on
+// the robot.
+#include <stdio.h>
+#include "DebugMenu.h"
+#include "HostArduino.h"
+#include "HostCheck.h"
+
+static const unsigned long dacWriteUs = 360;
+
+static void characterize(MecanumDrive &drive, XboxController &xbox, LatencyProbe &probe, const char *label) {
+  printf("--- %s ---\n", label);
+  drive.setClosedLoopEnabled(true);
+  hostSerialInput("lq");
+  unsigned long writesBefore = hostDacWrites();
+  enterDebugMode(drive, xbox, probe);
+  // The scripted steps plus the DAC reset before and after the run
+  expect(hostDacWrites() - writesBefore == 400 * 4 + 2 * 4, "debug mode writes the DAC despite the closed loop");
+  expect(drive.isClosedLoopEnabled(), "leaving debug mode restores the closed loop");
+
+  // 20 repetitions of 20 scripted steps; each DAC write advances the clock
+  // by dacWriteUs, so the dac stage reads back the writes per step
+  const LatencyStats &dac = probe.getStats(LatencyProbe::STAGE_DAC);
+  const LatencyStats &update = probe.getStats(LatencyProbe::STAGE_UPDATE);
+  expect(dac.getCount() == 400, "every scripted step reaches the DAC");
+  expect(update.getCount() == 400, "every scripted step passes update()");
+  expect(update.getMax() == 0, "no DAC write before update()");
+  expect(dac.getMin() == 4 * dacWriteUs && dac.getMax() == 4 * dacWriteUs, "four channel writes per step");
+}
+
+// With the velocity loop on, move() only sets feed-forward; the dac stage
+// must be stamped when serviceVelocityLoop() writes the MCP4728
+static void closedLoopDacStage(MecanumDrive &drive, LatencyProbe &probe) {
+  drive.setLookupTableEnabled(false);
+  drive.enableMotors();
+  drive.setClosedLoopEnabled(true);
+  probe.reset();
+  probe.arm();
+
+  probe.mark(LatencyProbe::STAGE_INPUT);
+  drive.move(0, 1, 0);
+  const LatencyStats &dac = probe.getStats(LatencyProbe::STAGE_DAC);
+  expect(dac.getCount() == 0, "closed-loop move() does not stamp the dac stage");
+
+  hostAdvanceMicros(10000);
+  drive.serviceVelocityLoop();
+  expect(dac.getCount() == 1, "velocity loop stamps the dac stage");
+  expect(dac.getMin() >= 10000, "dac stage includes the wait for the control tick");
+
+  probe.disarm();
+  drive.disableMotors();
+  drive.setClosedLoopEnabled(false);
+}
+
+// After scripted input the axes must come from the controller again, even
+// before the next report arrives
+static void scriptedInputReleased(XboxController &xbox) {
+  xbox.setScriptedInput(0, 32767, 0);
+  xbox.update();
+  expect(xbox.getY() == 1, "scripted input drives the axes");
+  xbox.clearScriptedInput();
+  xbox.update();
+  expect(xbox.getY() == 0, "clearing scripted input re-reads the centred stick");
+}
+
+int main() {
+  hostSetSerialEcho(true);
+  hostSetDacWriteUs(dacWriteUs);
+
+  USB usb;
+  XboxController xbox(&usb);
+  MecanumDrive drive;
+  LatencyProbe probe(micros);
+  xbox.setLatencyProbe(&probe);
+  drive.setLatencyProbe(&probe);
+  drive.initialize();
+
+  characterize(drive, xbox, probe, "direct path");
+
+  drive.setLookupTableEnabled(true);
+  while (!drive.isLookupTableReady()) {
+    drive.serviceLookupTable();
+  }
+  characterize(drive, xbox, probe, "lookup table");
+
+  closedLoopDacStage(drive, probe);
+  scriptedInputReleased(xbox);
+
+  return hostCheckSummary();
+}
@@ -0,0 +1,42 @@
+// Checks that live tuning changes reach EEPROM a byte per loop instead of
+// stalling the caller for the whole record.
+#include <string.h>
+#include <EEPROM.h>
+#include "MecanumDrive.h"
+#include "HostCheck.h"
+
+int main() {
+  memset(EEPROM.bytes, 0xFF, sizeof(EEPROM.bytes)); // Erased
+  EEPROM.writes = 0;
+
+  MecanumDrive drive;
+  expect(drive.setRampFactor(3.0), "ramp factor in range is accepted");
+  expect(drive.setStrafingScale(0.25), "strafing scale in range is accepted");
+  expect(EEPROM.writes == 0, "setters do not write EEPROM");
+
+  DriveTuning stored;
+  expect(!DriveTable::loadTuning(stored), "nothing valid stored before the loop runs");
+
+  // One byte per loop, the tuning takes effect right away
+  bool atMostOneByte = true;
+  for (int loop = 0; loop < 64; loop++) {
+    unsigned long before = EEPROM.writes;
+    drive.serviceLookupTable();
+    if (EEPROM.writes - before > 1) atMostOneByte = false;
+  }
+  expect(atMostOneByte, "at most one EEPROM byte written per loop");
+  expect(drive.getRampFactor() == 3.0f, "ramp factor applies before it is saved");
+
+  expect(DriveTable::loadTuning(stored), "record is valid once written");
+  expect(stored.rampFactor == 3.0f && stored.strafingScale == 0.25f, "both values are saved");
+
+  // Saving the same values again rewrites nothing
+  unsigned long writes = EEPROM.writes;
+  drive.setRampFactor(3.0);
+  for (int loop = 0; loop < 64; loop++) {
+    drive.serviceLookupTable();
+  }
+  expect(EEPROM.writes == writes, "unchanged bytes are not rewritten");
+
+  return hostCheckSummary();
+}
@@ -0,0 +1,24 @@
+// Host stand-in for the port K encoder capture, counts are injected by tests
+#include "QuadratureEncoders.h"
+#include "FakeQuadratureEncoders.h"
+
+static int32_t fakeCounts[QuadratureEncoders::WHEELS];
+
+void hostAddEncoderCounts(uint8_t wheel, int32_t counts) {
+  fakeCounts[wheel] += counts;
+}
+
+void QuadratureEncoders::begin() {
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    fakeCounts[wheel] = 0;
+    lastCounts[wheel] = 0;
+  }
+}
+
+void QuadratureEncoders::readDeltas(int16_t deltas[WHEELS]) {
+  for (uint8_t wheel = 0; wheel < WHEELS; wheel++) {
+    int16_t counts = (int16_t)fakeCounts[wheel];
+    deltas[wheel] = (int16_t)(counts - lastCounts[wheel]);
+    lastCounts[wheel] = counts;
+  }
+}
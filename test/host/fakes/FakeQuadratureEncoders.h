@@ -0,0 +1,10 @@
+// Controls for the host stand-in of QuadratureEncoders
+#ifndef FAKEQUADRATUREENCODERS_H
+#define FAKEQUADRATUREENCODERS_H
+
+#include <stdint.h>
+
+// Add edges to a wheel's counter as if the port K interrupt had seen them
+void hostAddEncoderCounts(uint8_t wheel, int32_t counts);
+
+#endif // FAKEQUADRATUREENCODERS_H
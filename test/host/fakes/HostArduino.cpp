@@ -0,0 +1,98 @@
+#include <Arduino.h>
+#include <Adafruit_MCP4728.h>
+#include <EEPROM.h>
+#include <stdio.h>
+#include <deque>
+#include "HostArduino.h"
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+static unsigned long fakeMicros = 0;
+static unsigned long dacWriteUs = 360;
+static uint16_t dacValues[4];
+static unsigned long dacWrites = 0;
+static int pinLevels[128];
+static std::deque<uint8_t> serialInput;
+static std::string serialOutput;
+static bool serialEcho = false;
+
+void hostSetMicros(unsigned long us) { fakeMicros = us; }
+void hostAdvanceMicros(unsigned long us) { fakeMicros += us; }
+void hostSetDacWriteUs(unsigned long us) { dacWriteUs = us; }
+uint16_t hostDacValue(uint8_t channel) { return dacValues[channel]; }
+unsigned long hostDacWrites() { return dacWrites; }
+int hostPinLevel(int pin) { return pinLevels[pin]; }
+void hostSetSerialEcho(bool echo) { serialEcho = echo; }
+
+void hostSerialInput(const std::string &bytes) {
+  serialInput.insert(serialInput.end(), bytes.begin(), bytes.end());
+}
+
+std::string hostTakeSerialOutput() {
+  std::string output;
+  output.swap(serialOutput);
+  return output;
+}
+
+// Arduino core
+void pinMode(int, int) {}
+void digitalWrite(int pin, int value) { pinLevels[pin] = value; }
+int digitalRead(int pin) { return pinLevels[pin]; }
+unsigned long millis() { return fakeMicros / 1000; }
+unsigned long micros() { return fakeMicros; }
+void delay(unsigned long ms) { fakeMicros += ms * 1000; }
+
+// MCP4728
+bool Adafruit_MCP4728::begin() { return true; }
+
+bool Adafruit_MCP4728::setChannelValue(MCP4728_channel_t channel, uint16_t value) {
+  dacValues[channel] = value;
+  dacWrites++;
+  fakeMicros += dacWriteUs;
+  return true;
+}
+
+// Serial
+int HardwareSerial::available() { return serialInput.size(); }
+
+int HardwareSerial::read() {
+  if (serialInput.empty()) return -1;
+  uint8_t byte = serialInput.front();
+  serialInput.pop_front();
+  return byte;
+}
+
+size_t HardwareSerial::write(uint8_t byte) {
+  serialOutput += (char)byte;
+  if (serialEcho) putchar(byte);
+  return 1;
+}
+
+// Print
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+size_t Print::print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+size_t Print::print(const String &text) { return print(text.c_str()); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+
+size_t Print::print(long value, int base) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%ld", value);
+  return print(buffer);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", value);
+  return print(buffer);
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return print(buffer);
+}
@@ -0,0 +1,32 @@
+// Controls for the host stand-ins of the Arduino core and the MCP4728
+#ifndef HOSTARDUINO_H
+#define HOSTARDUINO_H
+
+#include <stdint.h>
+#include <string>
+
+// Fake clock, only moves when a test or a modeled peripheral advances it
+void hostSetMicros(unsigned long us);
+void hostAdvanceMicros(unsigned long us);
+
+// Time charged to the fake clock for each MCP4728 channel write
+// Default: address plus three data bytes at 100 kHz I2C
+void hostSetDacWriteUs(unsigned long us);
+
+// Last value written to each MCP4728 channel and the number of writes
+uint16_t hostDacValue(uint8_t channel);
+unsigned long hostDacWrites();
+
+// Last level written to a digital pin
+int hostPinLevel(int pin);
+
+// Queue bytes for Serial.read()
+void hostSerialInput(const std::string &bytes);
+
+// Everything printed to Serial since the last call
+std::string hostTakeSerialOutput();
+
+// Echo Serial output to stdout as well
+void hostSetSerialEcho(bool echo);
+
+#endif // HOSTARDUINO_H
@@ -0,0 +1,28 @@
+// Check helpers shared by the host tests
+#ifndef HOSTCHECK_H
+#define HOSTCHECK_H
+
+#include <stdio.h>
+
+// Number of failed checks so far
+inline int &hostCheckFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+// Record a failed check without stopping the test
+inline void expect(bool condition, const char *what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    hostCheckFailures()++;
+  }
+}
+
+// Print the summary, returns the exit code for main()
+inline int hostCheckSummary() {
+  int failures = hostCheckFailures();
+  printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
+
+#endif // HOSTCHECK_H
@@ -0,0 +1,182 @@
+// Feeds SetpointLink byte streams with corrupted, malformed, replayed and
+// reordered frames and checks which ones are applied and how the status
+// counters account for them.
+#include <stdio.h>
+#include "HostCheck.h"
+#include "SetpointLink.h"
+
+// Feed bytes one at a time, returns true if the last one completed a frame
+static bool feedBytes(SetpointLink &link, const uint8_t *bytes, uint8_t count, unsigned long nowMs) {
+  bool accepted = false;
+  for (uint8_t i = 0; i < count; i++) {
+    accepted = link.feed(bytes[i], nowMs);
+  }
+  return accepted;
+}
+
+// Feed a complete frame, returns true if it was accepted
+static bool sendFrame(SetpointLink &link, uint8_t seq, uint8_t type, const uint8_t *payload,
+                      uint8_t length, unsigned long nowMs = 0) {
+  uint8_t frame[5 + 255 + 2] = {SetpointLink::SYNC_1, SetpointLink::SYNC_2, seq, type, length};
+  uint8_t n = 5;
+  for (uint8_t i = 0; i < length; i++) {
+    frame[n++] = payload[i];
+  }
+
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 2; i < n; i++) {
+    crc = SetpointLink::crcUpdate(crc, frame[i]);
+  }
+  frame[n++] = crc >> 8;
+  frame[n++] = crc & 0xFF;
+  return feedBytes(link, frame, n, nowMs);
+}
+
+// Feed a motion frame carrying y = value, returns true if it was accepted
+static bool sendMotion(SetpointLink &link, uint8_t seq, int16_t value, unsigned long nowMs = 0) {
+  uint8_t payload[6] = {0, 0, (uint8_t)(value & 0xFF), (uint8_t)((uint16_t)value >> 8), 0, 0};
+  return sendFrame(link, seq, SetpointLink::FRAME_MOTION, payload, sizeof(payload), nowMs);
+}
+
+static void testSequenceWindow() {
+  SetpointLink link;
+
+  expect(sendMotion(link, 250, 1000), "first frame sets the sequence");
+  expect(sendMotion(link, 251, 2000), "next frame is accepted");
+  expect(!sendMotion(link, 251, 3000), "duplicate is rejected");
+  expect(!sendMotion(link, 249, 4000), "older frame is rejected");
+  expect(link.getSetpoint(1) == 2000 / 32767.0f, "rejected frames keep the newer setpoint");
+
+  expect(sendMotion(link, 254, 5000), "gap is accepted");
+  expect(link.getDroppedFrames() == 2, "gap counts the skipped frames");
+  expect(sendMotion(link, 2, 6000), "sequence wraps mod 256");
+  expect(link.getDroppedFrames() == 5, "gap across the wrap is counted");
+  expect(!sendMotion(link, 2 + SetpointLink::SEQ_WINDOW, 7000), "frame outside the window is rejected");
+
+  expect(link.getStaleFrames() == 3, "stale frames are counted");
+  expect(link.getFramesOk() == 4, "only accepted frames count as ok");
+
+  uint8_t frame[SetpointLink::MAX_FRAME];
+  uint8_t length = link.encodeStatus(frame, 0);
+  expect(length == 5 + SetpointLink::STATUS_PAYLOAD + 2, "status frame length");
+  expect(frame[5 + 12] == 3 && frame[5 + 13] == 0, "status carries the stale count");
+  expect(frame[5 + 14] == 2, "status carries the last accepted sequence");
+}
+
+// A host that restarts mid-session starts again from sequence 0
+static void testHostRestart() {
+  SetpointLink link;
+  for (uint8_t seq = 0; seq <= 40; seq++) {
+    sendMotion(link, seq, 1000, seq * 10);
+  }
+
+  // Control frames are honoured whatever their sequence number
+  expect(sendFrame(link, 0, SetpointLink::FRAME_STATUS_REQUEST, 0, 0, 400),
+         "status request from a restarted host is accepted");
+  expect(link.getFrameType() == SetpointLink::FRAME_STATUS_REQUEST, "status request is reported");
+  expect(sendFrame(link, 1, SetpointLink::FRAME_EXIT, 0, 0, 400), "exit from a restarted host is accepted");
+  expect(link.getFrameType() == SetpointLink::FRAME_EXIT, "exit is reported");
+
+  // A stale setpoint from the new session is still rejected while the old
+  // stream is fresh, but the timeout lets the new session take over
+  expect(!sendMotion(link, 0, 2000, 405), "restarted setpoints are stale while the old stream is fresh");
+  expect(!link.hasFreshSetpoint(400 + SetpointLink::SETPOINT_TIMEOUT_MS + 1), "old stream times out");
+  expect(sendMotion(link, 0, 3000, 600), "setpoints from sequence 0 are accepted after the timeout");
+  expect(link.getSetpoint(1) == 3000 / 32767.0f, "the new session's setpoint is applied");
+  expect(link.getDroppedFrames() == 0, "restart does not count dropped frames");
+}
+
+static void testCrcErrors() {
+  SetpointLink link;
+  uint8_t frame[] = {SetpointLink::SYNC_1, SetpointLink::SYNC_2, 7, SetpointLink::FRAME_EXIT, 0, 0, 0};
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 2; i < 5; i++) {
+    crc = SetpointLink::crcUpdate(crc, frame[i]);
+  }
+  frame[5] = crc >> 8;
+  frame[6] = (crc & 0xFF) ^ 0x01;
+  expect(!feedBytes(link, frame, sizeof(frame), 0), "frame with a bad CRC is rejected");
+  expect(link.getCrcErrors() == 1, "bad CRC is counted");
+
+  // A corrupted header byte fails the CRC too
+  frame[6] ^= 0x01;
+  frame[3] = SetpointLink::FRAME_STATUS_REQUEST;
+  expect(!feedBytes(link, frame, sizeof(frame), 0), "corrupted header is rejected");
+  expect(link.getCrcErrors() == 2, "corrupted header is counted");
+  expect(link.getFramesOk() == 0, "no corrupted frame counts as ok");
+}
+
+static void testFramingErrors() {
+  SetpointLink link;
+
+  // Length above MAX_PAYLOAD is rejected as soon as the length byte arrives
+  uint8_t oversized[] = {SetpointLink::SYNC_1, SetpointLink::SYNC_2, 1, SetpointLink::FRAME_MOTION,
+                         SetpointLink::MAX_PAYLOAD + 1};
+  expect(!feedBytes(link, oversized, sizeof(oversized), 0), "oversized frame is rejected");
+  expect(link.getFramingErrors() == 1, "oversized frame is counted");
+
+  // Unknown type and wrong payload length for a known type pass the CRC but
+  // are still framing errors
+  uint8_t payload[8] = {0};
+  expect(!sendFrame(link, 2, 0x42, payload, 2), "unknown frame type is rejected");
+  expect(!sendFrame(link, 3, SetpointLink::FRAME_MOTION, payload, 8), "motion frame with a wheel payload is rejected");
+  expect(link.getFramingErrors() == 3, "unknown type and bad length are counted");
+  expect(link.getCrcErrors() == 0, "framing errors are not CRC errors");
+
+  // The parser is back at the sync state, the next frame goes through
+  expect(sendMotion(link, 4, 1000), "frame after framing errors is accepted");
+}
+
+static void testResync() {
+  SetpointLink link;
+
+  // Line noise with stray sync bytes ahead of a frame
+  uint8_t noise[] = {0x00, SetpointLink::SYNC_1, 0x13, SetpointLink::SYNC_2, 0xFF, SetpointLink::SYNC_1};
+  expect(!feedBytes(link, noise, sizeof(noise), 0), "noise completes no frame");
+
+  // The trailing SYNC_1 doubles up with the frame's own SYNC_1
+  expect(sendMotion(link, 9, 1234), "frame after a false sync is accepted");
+  expect(link.getSetpoint(1) == 1234 / 32767.0f, "frame after a false sync is decoded");
+  expect(link.getCrcErrors() == 0 && link.getFramingErrors() == 0, "noise between frames is not an error");
+
+  // A frame cut short is lost, and the next one is found again. The cut
+  // frame swallows the next frame's first bytes as its CRC, so that frame
+  // also fails; the one after resyncs.
+  uint8_t truncated[] = {SetpointLink::SYNC_1, SetpointLink::SYNC_2, 10, SetpointLink::FRAME_MOTION, 6, 1, 2};
+  feedBytes(link, truncated, sizeof(truncated), 0);
+  sendMotion(link, 11, 2000);
+  expect(sendMotion(link, 12, 3000), "parser resyncs after a truncated frame");
+  expect(link.getSetpoint(1) == 3000 / 32767.0f, "frame after the resync is decoded");
+}
+
+static void testTimeouts() {
+  SetpointLink link;
+  expect(!link.hasFreshSetpoint(0), "no setpoint before the first frame");
+
+  sendMotion(link, 0, 1000, 1000);
+  expect(link.hasFreshSetpoint(1000 + SetpointLink::SETPOINT_TIMEOUT_MS), "setpoint fresh up to the timeout");
+  expect(!link.hasFreshSetpoint(1000 + SetpointLink::SETPOINT_TIMEOUT_MS + 1), "setpoint stale after the timeout");
+  expect(!link.hasFreshSetpoint(5000), "stays stale");
+  expect(link.getTimeouts() == 1, "one timeout per stale transition");
+
+  sendMotion(link, 1, 1000, 6000);
+  expect(link.hasFreshSetpoint(6050), "new frame makes the setpoint fresh again");
+  expect(!link.hasFreshSetpoint(6000 + SetpointLink::SETPOINT_TIMEOUT_MS + 1), "second stream times out");
+  expect(link.getTimeouts() == 2, "second timeout is counted");
+
+  // Status and exit frames do not keep the setpoint alive
+  sendMotion(link, 2, 1000, 7000);
+  sendFrame(link, 3, SetpointLink::FRAME_STATUS_REQUEST, 0, 0, 7090);
+  expect(!link.hasFreshSetpoint(7000 + SetpointLink::SETPOINT_TIMEOUT_MS + 1), "status requests do not refresh the setpoint");
+}
+
+int main() {
+  testSequenceWindow();
+  testHostRestart();
+  testCrcErrors();
+  testFramingErrors();
+  testResync();
+  testTimeouts();
+
+  return hostCheckSummary();
+}
@@ -0,0 +1,20 @@
+// Host stand-in for the MCP4728 driver, writes land in HostArduino.cpp
+#ifndef ADAFRUIT_MCP4728_H
+#define ADAFRUIT_MCP4728_H
+
+#include <stdint.h>
+
+typedef enum {
+  MCP4728_CHANNEL_A,
+  MCP4728_CHANNEL_B,
+  MCP4728_CHANNEL_C,
+  MCP4728_CHANNEL_D
+} MCP4728_channel_t;
+
+class Adafruit_MCP4728 {
+public:
+  bool begin();
+  bool setChannelValue(MCP4728_channel_t channel, uint16_t value);
+};
+
+#endif // ADAFRUIT_MCP4728_H
@@ -0,0 +1,79 @@
+// Host stand-in for the Arduino core, just enough to build the sketch
+// sources off-target. Time, pins and Serial are backed by HostArduino.cpp.
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define PI 3.1415926535897932384626433832795
+#define DEC 10
+#define HEX 16
+#define F(string_literal) (string_literal)
+
+typedef uint8_t byte;
+
+template <class T, class L, class H> T constrain(T value, L low, H high) {
+  return value < low ? low : (value > high ? high : value);
+}
+template <class T> T max(T a, T b) { return a > b ? a : b; }
+template <class T> T min(T a, T b) { return a < b ? a : b; }
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String : public std::string {
+public:
+  String(const char *text = "") : std::string(text) {}
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t byte) = 0;
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *text);
+  size_t print(const String &text);
+  size_t print(char c);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return print("\r\n"); }
+  template <class T> size_t println(const T &value) { return print(value) + println(); }
+  template <class T> size_t println(const T &value, int format) { return print(value, format) + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  int available();
+  int read();
+  long parseInt() { return 0; }
+  void flush() {}
+  size_t write(uint8_t byte) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // ARDUINO_H
@@ -0,0 +1,35 @@
+// Host stand-in for the EEPROM library, backed by a byte array
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass {
+public:
+  template <class T> T &get(int address, T &value) {
+    memcpy(&value, bytes + address, sizeof(T));
+    return value;
+  }
+  template <class T> const T &put(int address, const T &value) {
+    memcpy(bytes + address, &value, sizeof(T));
+    return value;
+  }
+  uint8_t read(int address) { return bytes[address]; }
+  void update(int address, uint8_t value) {
+    if (bytes[address] != value) {
+      bytes[address] = value;
+      writes++;
+    }
+  }
+
+  uint8_t bytes[4096];
+  unsigned long writes = 0; // Bytes rewritten by update()
+};
+
+// avr-libc: true when no EEPROM write is in progress
+inline bool eeprom_is_ready() { return true; }
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_H
@@ -0,0 +1,17 @@
+// Host stand-in for the USB Host Shield core
+#ifndef USB_H
+#define USB_H
+
+#include <Arduino.h>
+
+#define rHIEN 0xD0
+#define bmCONDETIE 0x20
+
+class USB {
+public:
+  int Init() { return 0; }
+  void Task() {}
+  void regWr(uint8_t, uint8_t) {}
+};
+
+#endif // USB_H
@@ -0,0 +1,28 @@
+// Host stand-in for the XBOXUSB driver, the report is set directly by tests
+#ifndef XBOXUSB_H
+#define XBOXUSB_H
+
+#include <Usb.h>
+
+enum AnalogHatEnum { LeftHatX, LeftHatY, RightHatX, RightHatY };
+enum ButtonEnum { LT, XBOX };
+enum LEDModeEnum { ROTATING };
+enum LEDEnum { LED1, LED4, ALL };
+
+class XBOXUSB {
+public:
+  XBOXUSB(USB *) {}
+
+  int16_t getAnalogHat(AnalogHatEnum hat) { return hats[hat]; }
+  uint8_t getButtonPress(ButtonEnum button) { return buttons[button]; }
+  void setRumbleOn(uint8_t, uint8_t) {}
+  void setLedMode(LEDModeEnum) {}
+  void setLedOn(LEDEnum) {}
+  void setLedBlink(LEDEnum) {}
+
+  bool Xbox360Connected = true;
+  int16_t hats[4] = {0, 0, 0, 0};
+  uint8_t buttons[2] = {0, 0};
+};
+
+#endif // XBOXUSB_H
@@ -0,0 +1,220 @@
+// Runs the wheel velocity loop against a simulated motor and encoder. Each
+// motor settles to a speed proportional to its DAC code, scaled down by a
+// load, with a first-order lag. Checks that the loop removes the load error
+// and that the integrator does not wind up while the output is saturated.
+// Through MecanumDrive, checks that irregular loop() intervals and uneven
+// wheel loads leave no speed bias or heading drift, that the DAC frames do
+// not flood the flight recorder, and that stalled ticks fall back to the
+// feed-forward.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "MecanumDrive.h"
+#include "HostArduino.h"
+#include "HostCheck.h"
+#include "FakeQuadratureEncoders.h"
+#include "FlightRecorder.h"
+
+static const unsigned long PERIOD_US = 10000;
+static const float FULL_SCALE_COUNTS = 51.2;   // Counts per tick at code 4095 with no load
+static const float TIME_CONSTANT_US = 30000;
+
+// First-order motor with a quadrature encoder
+struct MotorModel {
+  float speed;    // Counts per tick
+  float position; // Counts, fractional
+  long counts;    // Whole counts reported to the encoder
+
+  MotorModel() : speed(0), position(0), counts(0) {}
+
+  // Advance by stepUs at a DAC code, returns the new whole encoder counts
+  long step(int16_t code, float load, unsigned long stepUs) {
+    float steady = code * FULL_SCALE_COUNTS / 4095 * load;
+    speed += (steady - speed) * stepUs / TIME_CONSTANT_US;
+    position += speed * stepUs / PERIOD_US;
+    long whole = (long)position;
+    long added = whole - counts;
+    counts = whole;
+    return added;
+  }
+};
+
+// Drive one wheel of a bare controller at fixed ticks, returns the mean
+// absolute error in Q4 counts over the last measureTicks ticks
+static int runController(WheelVelocityController &controller, MotorModel &motor, int16_t &code,
+                         float load, int ticks, int measureTicks, int16_t *peakMeasured) {
+  long errorSum = 0;
+  for (int tick = 0; tick < ticks; tick++) {
+    long counts = 0;
+    for (int ms = 0; ms < 10; ms++) {
+      counts += motor.step(code, load, 1000);
+    }
+    code = controller.update(0, (int16_t)counts, PERIOD_US);
+    if (peakMeasured && controller.getMeasured(0) > *peakMeasured) {
+      *peakMeasured = controller.getMeasured(0);
+    }
+    if (tick >= ticks - measureTicks) {
+      errorSum += abs(controller.getError(0));
+    }
+  }
+  return errorSum / measureTicks;
+}
+
+static void testTracking() {
+  WheelVelocityController controller(PERIOD_US, 51, 10240, 2048);
+  MotorModel motor;
+  int16_t code = 0;
+
+  // Half speed against a load that costs 25% of the speed open loop
+  controller.setFeedForward(0, 2048);
+  int meanError = runController(controller, motor, code, 0.75, 300, 100, 0);
+  printf("tracking: target %.2f, speed %.2f, mean |error| %.2f counts/tick\n",
+         controller.getTarget(0) / 16.0, motor.speed, meanError / 16.0);
+  expect(meanError <= 16, "tracks the target within one count per tick under load");
+  expect(abs(motor.speed - controller.getTarget(0) / 16.0) < 0.5, "wheel speed settles on the target");
+}
+
+static void testAntiWindup() {
+  WheelVelocityController controller(PERIOD_US, 51, 10240, 2048);
+  MotorModel motor;
+  int16_t code = 0;
+
+  // Near full speed against a load the motor cannot overcome: the output
+  // saturates for a second
+  controller.setFeedForward(0, 3800);
+  runController(controller, motor, code, 0.6, 100, 1, 0);
+  expect(code == WheelVelocityController::MAX_CODE, "output saturates under the stall load");
+
+  // Release the load, the wheel must not overshoot on a wound-up integral
+  int16_t peak = 0;
+  int meanError = runController(controller, motor, code, 1.0, 100, 50, &peak);
+  float overshoot = (peak - controller.getTarget(0)) / 16.0;
+  printf("anti-windup: target %.2f, peak %.2f, overshoot %.2f counts/tick\n",
+         controller.getTarget(0) / 16.0, peak / 16.0, overshoot);
+  expect(overshoot < 2.0, "no windup overshoot after saturation");
+  expect(meanError <= 16, "recovers the target after the load is released");
+}
+
+// Drive straight ahead through MecanumDrive with the main loop taking 3 to
+// 11 ms per pass and a different load on every wheel. Accumulates the mean
+// speed error of each wheel over the last 100 passes, returns the heading
+// drift: how many counts the left wheels ran ahead of the right ones.
+static float runIrregularLoop(MecanumDrive &drive, bool closedLoop, const float loads[4], float speedBias[4]) {
+  const int directionPins[4] = {30, 32, 36, 34};
+  const unsigned long loopUs[] = {4000, 9000, 3000, 11000, 6000, 5000, 8000};
+  const uint8_t loopPattern = sizeof(loopUs) / sizeof(loopUs[0]);
+  MotorModel motors[4];
+
+  hostSetDacWriteUs(0);
+  hostSetMicros(0);
+  flightRecorder.begin(0);
+  drive.initialize();
+  drive.enableMotors();
+  drive.setClosedLoopEnabled(closedLoop);
+  drive.setWheelPowers(0.5, 0.5, 0.5, 0.5);
+
+  WheelVelocityController &controller = drive.getVelocityController();
+  int samples = 0;
+  for (uint8_t wheel = 0; wheel < 4; wheel++) {
+    speedBias[wheel] = 0;
+  }
+  for (int pass = 0; pass < 400; pass++) {
+    unsigned long passUs = loopUs[pass % loopPattern];
+    for (unsigned long us = 0; us < passUs; us += 1000) {
+      for (uint8_t wheel = 0; wheel < 4; wheel++) {
+        int16_t code = hostDacValue(wheel);
+        if (hostPinLevel(directionPins[wheel]) == HIGH) code = -code;
+        hostAddEncoderCounts(wheel, motors[wheel].step(code, loads[wheel], 1000));
+      }
+      hostAdvanceMicros(1000);
+    }
+    drive.serviceVelocityLoop();
+
+    if (pass >= 300) {
+      for (uint8_t wheel = 0; wheel < 4; wheel++) {
+        speedBias[wheel] += abs(motors[wheel].speed) - abs(controller.getTarget(wheel) / 16.0);
+      }
+      samples++;
+    }
+  }
+  for (uint8_t wheel = 0; wheel < 4; wheel++) {
+    speedBias[wheel] /= samples;
+  }
+
+  // Channels are front-left, front-right, rear-left, rear-right
+  return abs(motors[0].position) + abs(motors[2].position) - abs(motors[1].position) - abs(motors[3].position);
+}
+
+static void testIrregularLoop() {
+  // A dragging wheel on each side, unevenly, all within what the integral
+  // term may add at half speed
+  const float loads[4] = {0.95, 0.75, 0.85, 0.7};
+  float bias[4];
+  MecanumDrive drive;
+
+  float closedLoopDrift = runIrregularLoop(drive, true, loads, bias);
+  for (uint8_t wheel = 0; wheel < 4; wheel++) {
+    printf("irregular loop: wheel %d load %.2f speed bias %.2f counts/tick\n", wheel, loads[wheel], bias[wheel]);
+    expect(bias[wheel] > -0.5 && bias[wheel] < 0.5, "irregular ticks leave no speed bias");
+  }
+  // The loop rewrites the DAC every tick for the whole run, but the trace
+  // keeps one DAC frame per 250 ms
+  drive.disableMotors();
+  unsigned long runMs = millis();
+  hostTakeSerialOutput();
+  flightRecorder.dump(Serial);
+  std::string trace = hostTakeSerialOutput();
+  int dacFrames = 0;
+  for (size_t line = trace.find("FR "); line != std::string::npos; line = trace.find("FR ", line + 1)) {
+    if (trace.compare(line + 7, 4, " 05 ") == 0) dacFrames++;
+  }
+  printf("flight recorder: %d DAC frames in %lu ms\n", dacFrames, runMs);
+  expect(dacFrames <= (int)(runMs / 250) + 2, "DAC frames are rate limited");
+  expect(dacFrames >= 2, "start and stop are recorded");
+
+  // The same run open loop drifts off the heading
+  float openLoopDrift = runIrregularLoop(drive, false, loads, bias);
+  drive.disableMotors();
+  printf("irregular loop: heading drift %.0f counts closed loop, %.0f counts open loop\n",
+         closedLoopDrift, openLoopDrift);
+  expect(openLoopDrift > 1000, "uneven loads turn the robot open loop");
+  expect(abs(closedLoopDrift) < openLoopDrift / 10, "closed loop keeps the heading");
+}
+
+// Passes of two control periods or more skip the correction, the DAC must
+// still follow the setpoint
+static void testStalledLoop() {
+  hostSetDacWriteUs(0);
+  hostSetMicros(0);
+  MecanumDrive drive;
+  drive.initialize();
+  drive.enableMotors();
+  drive.setClosedLoopEnabled(true);
+  WheelVelocityController &controller = drive.getVelocityController();
+
+  const float powers[] = {0.5, 0.25};
+  for (uint8_t step = 0; step < 2; step++) {
+    drive.setWheelPowers(powers[step], powers[step], powers[step], powers[step]);
+    for (int pass = 0; pass < 3; pass++) {
+      hostAddEncoderCounts(0, 40);
+      hostAdvanceMicros(2 * PERIOD_US + 5000);
+      drive.serviceVelocityLoop();
+    }
+    bool feedForward = true;
+    for (uint8_t wheel = 0; wheel < 4; wheel++) {
+      feedForward = feedForward && hostDacValue(wheel) == abs(controller.getFeedForward(wheel));
+    }
+    expect(controller.getFeedForward(0) != 0, "stalled loop has a setpoint");
+    expect(feedForward, "stalled ticks output the feed-forward of the current setpoint");
+  }
+  drive.disableMotors();
+}
+
+int main() {
+  testTracking();
+  testAntiWindup();
+  testIrregularLoop();
+  testStalledLoop();
+
+  return hostCheckSummary();
+}
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Rebuild a timeline from a flight recorder dump (see FlightRecorder.h).
+
+Reads a serial log containing one or more dumps ("FLIGHT RECORDER BEGIN" ...
+"FLIGHT RECORDER END") and decodes the last one. Timestamps are the low 16
+bits of millis(), so they are unwrapped per boot assuming no two consecutive
+events are more than 65.5 s apart.
+
+Example:
+    python3 tools/flight_decode.py capture.log
+"""
+
+import argparse
+import sys
+
+FLIGHT_BOOT = 1
+FLIGHT_STATE = 2
+FLIGHT_FAULT = 3
+FLIGHT_DEADMAN = 4
+FLIGHT_DAC = 5
+FLIGHT_LOOP_OVERRUN = 6
+
+STATES = {
+    1: "waiting for Xbox button",
+    2: "running",
+    3: "motor fault",
+    4: "motor fault cleared",
+    5: "MecanumDrive::initialize() failed, locked up",
+    6: "debug mode",
+    7: "binary host control",
+    8: "main menu",
+}
+
+# ATmega2560 MCUSR bits
+RESET_FLAGS = {0x01: "power-on", 0x02: "external", 0x04: "brown-out", 0x08: "watchdog", 0x10: "JTAG"}
+
+WHEELS = ["FL", "FR", "RL", "RR"]
+
+
+def parse_dump(lines):
+    """Return the records of the last complete dump as (time, type, arg, data) tuples."""
+    dumps, current = [], None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("FLIGHT RECORDER BEGIN"):
+            current = []
+        elif line.startswith("FLIGHT RECORDER END") and current is not None:
+            dumps.append(current)
+            current = None
+        elif line.startswith("FR ") and current is not None:
+            time, type_, arg, data = (int(field, 16) for field in line.split()[1:5])
+            current.append((time, type_, arg, data))
+    return dumps[-1] if dumps else None
+
+
+def describe(type_, arg, data):
+    if type_ == FLIGHT_BOOT:
+        causes = [name for bit, name in RESET_FLAGS.items() if arg & bit] or ["unknown"]
+        return f"BOOT       reset cause: {', '.join(causes)} (MCUSR=0x{arg:02X})"
+    if type_ == FLIGHT_STATE:
+        return f"STATE      {STATES.get(arg, f'unknown state {arg}')}"
+    if type_ == FLIGHT_FAULT:
+        faulted = [WHEELS[i] for i in range(4) if arg & (1 << i)]
+        return f"FAULT PINS {'LOW on ' + ', '.join(faulted) if faulted else 'all clear'}"
+    if type_ == FLIGHT_DEADMAN:
+        return f"DEADMAN    {'held' if arg else 'released'}"
+    if type_ == FLIGHT_DAC:
+        codes = []
+        for i in range(4):
+            code = ((data >> (8 * i)) & 0xFF) << 4
+            codes.append(f"{WHEELS[i]}={-code if arg & (1 << i) else code:+5d}")
+        return f"DAC        {' '.join(codes)}"
+    if type_ == FLIGHT_LOOP_OVERRUN:
+        return f"OVERRUN    loop took {data} ms"
+    return f"UNKNOWN    type {type_} arg 0x{arg:02X} data 0x{data:08X}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", nargs="?", help="Serial log (default: stdin)")
+    args = parser.parse_args()
+
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as source:
+        records = parse_dump(source)
+    if records is None:
+        print("no complete flight recorder dump found", file=sys.stderr)
+        return 1
+
+    # Events before the oldest surviving BOOT belong to an unknown boot
+    boot = -1
+    epoch = None
+    previous = None
+    for time, type_, arg, data in records:
+        if type_ == FLIGHT_BOOT:
+            boot += 1
+            epoch = 0
+            previous = None
+        elif previous is not None and time < previous:
+            epoch += 1 << 16
+        if epoch is None:
+            epoch = 0
+        previous = time
+
+        label = f"boot {boot}" if boot >= 0 else "boot ?"
+        print(f"[{label:>7}] {(epoch + time) / 1000:10.3f} s  {describe(type_, arg, data)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
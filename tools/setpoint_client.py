@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""Host-side client for the binary setpoint channel (see SetpointLink.h).
+
+Streams setpoint frames at a fixed rate, optionally skipping, corrupting or
+repeating frames, then asks the base for its link statistics and checks them
+against what was sent. Motion still requires the deadman on the Xbox controller.
+
+Example:
+    python3 tools/setpoint_client.py /dev/ttyACM0 --rate 500 --duration 10 --drop-every 50
+"""
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+import serial
+
+SYNC = b"\xa5\x5a"
+FRAME_MOTION = 0x01
+FRAME_WHEELS = 0x02
+FRAME_STATUS_REQUEST = 0x10
+FRAME_EXIT = 0x7F
+FRAME_STATUS = 0x90
+STATUS_FORMAT = "<IHHHHHBB"
+MENU_BANNER = b"Main Menu"
+HOST_CONTROL_BANNER = b"Entering binary host control"
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, matching SetpointLink::crcUpdate()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(seq, frame_type, payload=b"", corrupt=False):
+    body = bytes([seq & 0xFF, frame_type, len(payload)]) + payload
+    crc = crc16(body) ^ (0x0001 if corrupt else 0)
+    return SYNC + body + struct.pack(">H", crc)
+
+
+def q15(value):
+    return int(round(max(-1.0, min(1.0, value)) * 32767))
+
+
+def read_status(port, timeout=1.0):
+    """Read bytes until a valid FRAME_STATUS arrives, return its fields."""
+    deadline = time.monotonic() + timeout
+    buffer = b""
+    while time.monotonic() < deadline:
+        buffer += port.read(port.in_waiting or 1)
+        start = buffer.find(SYNC)
+        while start >= 0 and len(buffer) - start >= 7:
+            length = buffer[start + 4]
+            end = start + 5 + length + 2
+            if len(buffer) < end:
+                break
+            body = buffer[start + 2:end - 2]
+            (crc,) = struct.unpack(">H", buffer[end - 2:end])
+            if buffer[start + 3] == FRAME_STATUS and crc16(body) == crc:
+                return struct.unpack(STATUS_FORMAT, body[3:])
+            start = buffer.find(SYNC, start + 1)
+    return None
+
+
+def open_port(name, baud):
+    """Open the port with DTR held low, so opening it does not reset the Mega."""
+    port = serial.Serial()
+    port.port = name
+    port.baudrate = baud
+    port.timeout = 0
+    port.dtr = False
+    port.open()
+    return port
+
+
+def wait_for_text(port, text, timeout):
+    """Read until text arrives, returns False on timeout."""
+    deadline = time.monotonic() + timeout
+    buffer = b""
+    while time.monotonic() < deadline:
+        buffer += port.read(port.in_waiting or 1)
+        if text in buffer:
+            return True
+        time.sleep(0.01)
+    return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", help="Serial port of the base")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--rate", type=float, default=500, help="Frames per second")
+    parser.add_argument("--duration", type=float, default=5, help="Seconds to stream")
+    parser.add_argument("--mode", choices=["motion", "wheels"], default="motion")
+    parser.add_argument("--amplitude", type=float, default=0.0,
+                        help="Peak of the sine setpoint in [-1, 1] (default 0 commands a stop)")
+    parser.add_argument("--drop-every", type=int, default=0, help="Skip every Nth frame")
+    parser.add_argument("--corrupt-every", type=int, default=0, help="Corrupt the CRC of every Nth frame")
+    parser.add_argument("--repeat-every", type=int, default=0, help="Send every Nth frame twice")
+    args = parser.parse_args()
+
+    port = open_port(args.port, args.baud)
+
+    # Leave host control in case an earlier session never exited; at the
+    # menu these bytes only print "Invalid command"
+    port.write(encode_frame(0, FRAME_EXIT))
+    time.sleep(0.2)
+    port.reset_input_buffer()
+
+    # The base only shows its menu once setup is complete, [h] reprints it
+    port.write(b"h")
+    if not wait_for_text(port, MENU_BANNER, 5.0):
+        print("no main menu from the base; press the Xbox button to finish its setup")
+        return 1
+    time.sleep(0.2)
+    port.reset_input_buffer()
+
+    # Switch the main menu into binary host control
+    port.write(b"b")
+    if not wait_for_text(port, HOST_CONTROL_BANNER, 1.0):
+        print("base did not enter host control")
+        return 1
+    port.reset_input_buffer()
+
+    seq = 0
+    sent = dropped = corrupted = repeated = 0
+    period = 1.0 / args.rate
+    start = time.monotonic()
+    next_time = start
+    frame_index = 0
+
+    while time.monotonic() - start < args.duration:
+        frame_index += 1
+        value = args.amplitude * math.sin(2 * math.pi * 0.5 * (next_time - start))
+        if args.mode == "motion":
+            frame_type, payload = FRAME_MOTION, struct.pack("<hhh", 0, q15(value), 0)
+        else:
+            frame_type, payload = FRAME_WHEELS, struct.pack("<hhhh", *[q15(value)] * 4)
+
+        if args.drop_every and frame_index % args.drop_every == 0:
+            dropped += 1
+        else:
+            corrupt = bool(args.corrupt_every and frame_index % args.corrupt_every == 0)
+            frame = encode_frame(seq, frame_type, payload, corrupt)
+            port.write(frame)
+            corrupted += corrupt
+            sent += 1
+            if args.repeat_every and frame_index % args.repeat_every == 0 and not corrupt:
+                port.write(frame)
+                repeated += 1
+        seq = (seq + 1) & 0xFF
+
+        next_time += period
+        delay = next_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+    elapsed = time.monotonic() - start
+    port.flush()
+
+    port.write(encode_frame(seq, FRAME_STATUS_REQUEST))
+    status = read_status(port)
+    port.write(encode_frame((seq + 1) & 0xFF, FRAME_EXIT))
+    port.close()
+
+    print(f"sent {sent} frames in {elapsed:.2f} s ({sent / elapsed:.0f} Hz), "
+          f"skipped {dropped}, corrupted {corrupted}, repeated {repeated}")
+    if status is None:
+        print("no status reply")
+        return 1
+
+    frames_ok, crc_errors, framing_errors, dropped_frames, timeouts, stale_frames, last_seq, flags = status
+    print(f"base: ok {frames_ok}, crc errors {crc_errors}, framing errors {framing_errors}, "
+          f"dropped {dropped_frames}, timeouts {timeouts}, stale {stale_frames}, "
+          f"deadman {'held' if flags & 1 else 'released'}")
+
+    # The status request itself is counted as a valid frame
+    expected_ok = sent - corrupted + 1
+    expected_dropped = dropped + corrupted
+    lost = expected_ok - frames_ok
+    print(f"expected ok {expected_ok}, dropped {expected_dropped}, stale {repeated}; "
+          f"frames lost in transit: {lost}")
+    return 0 if lost == 0 and dropped_frames == expected_dropped and stale_frames == repeated else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())